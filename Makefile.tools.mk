@@ -0,0 +1,63 @@
+#!/usr/bin/make -f
+# Build rules for standalone programs running plugin DSP without a host, like benchmarks and tools
+# SPDX-License-Identifier: ISC
+#
+# include last, after setting TARGET, BUILD_DIR and FILES.
+# set AUDIO_FILE_INPUT to true for programs reading audio files, so FLAC support is added when available.
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Build flags
+
+BUILD_CXX_FLAGS += -I$(dir $(lastword $(MAKEFILE_LIST)))deps/dpf/distrho
+
+ifeq ($(AUDIO_FILE_INPUT),true)
+HAVE_FLAC = $(shell $(PKG_CONFIG) --exists flac && echo true)
+
+ifeq ($(HAVE_FLAC),true)
+BUILD_CXX_FLAGS += -DHAVE_FLAC $(shell $(PKG_CONFIG) --cflags flac)
+LINK_FLAGS += $(shell $(PKG_CONFIG) --libs flac)
+endif
+endif
+
+ifneq ($(WINDOWS),true)
+LINK_FLAGS += -lpthread
+endif
+
+ifeq ($(LINUX),true)
+LINK_FLAGS += -ldl -lrt
+endif
+
+OBJS = $(FILES:%=$(BUILD_DIR)/%.o)
+
+# ---------------------------------------------------------------------------------------------------------------------
+
+all: $(TARGET)
+
+clean:
+	rm -rf $(dir $(BUILD_DIR))
+	rm -f $(TARGET)
+
+# ---------------------------------------------------------------------------------------------------------------------
+
+$(TARGET): $(OBJS)
+	-@mkdir -p $(shell dirname $@)
+	@echo "Linking $(notdir $@)"
+	$(SILENT)$(CXX) $^ $(LINK_FLAGS) -o $@
+
+$(BUILD_DIR)/%.c.o: %.c
+	-@mkdir -p "$(shell dirname $(BUILD_DIR)/$<)"
+	@echo "Compiling $<"
+	$(SILENT)$(CC) $< $(BUILD_C_FLAGS) -c -o $@
+
+$(BUILD_DIR)/%.cpp.o: %.cpp
+	-@mkdir -p "$(shell dirname $(BUILD_DIR)/$<)"
+	@echo "Compiling $<"
+	$(SILENT)$(CXX) $< $(BUILD_CXX_FLAGS) -c -o $@
+
+# ---------------------------------------------------------------------------------------------------------------------
+
+-include $(OBJS:%.o=%.d)
+
+# ---------------------------------------------------------------------------------------------------------------------
+
+.PHONY: all clean
@@ -0,0 +1,878 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// standalone benchmark of the DSP side, running the plugin through DPF without a host.
+// results are written as JSON to stdout, so they can be stored and compared over time.
+
+#include "src/DistrhoPlugin.cpp"
+#include "src/DistrhoUtils.cpp"
+
+#include "AudioFile.hpp"
+#include "DspTiming.hpp"
+#include "RNNoiseArch.hpp"
+
+#include <cstdio>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static constexpr const uint32_t kNumChannels = DISTRHO_PLUGIN_NUM_INPUTS;
+
+// host block sizes to test, 0 means randomly varying sizes up to kMaxRandomBlockSize
+static constexpr const uint32_t kBlockSizes[] = { 1, 16, 32, 64, 128, 441, 480, 512, 1024, 4096, 0 };
+static constexpr const uint32_t kMaxRandomBlockSize = 4096;
+
+// generated audio is tested at these rates, files at their own rate
+static constexpr const double kSampleRates[] = { 48000.0, 44100.0 };
+
+// ISA parity runs use one denoise block per callback at 48kHz, so VAD can be read back for every block
+static constexpr const uint32_t kParityBlockSize = 480;
+
+// resume checks cut this much digital silence out of every second of audio, so inference is skipped and resumed
+static constexpr const double kResumeGapSeconds = 0.5;
+
+// denoise blocks looked at after every resume, well past the pre-roll
+static constexpr const uint32_t kResumeCheckBlocks = 8;
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct Audio {
+    double sampleRate = 0.0;
+    uint32_t numFrames = 0;
+    std::vector<float> channels[kNumChannels];
+};
+
+// small deterministic generator, so every run gets the same audio
+struct Random {
+    uint32_t state;
+
+    explicit Random(const uint32_t seed) noexcept
+        : state(seed) {}
+
+    uint32_t next() noexcept
+    {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+
+    float nextFloat() noexcept
+    {
+        return static_cast<float>(next() >> 8) / static_cast<float>(1 << 24) * 2.f - 1.f;
+    }
+};
+
+/**
+   Generate something resembling speech over background noise, so the denoiser has work to do.
+   The pitch glides and syllables come and go, which keeps the output correlation free of ambiguous peaks.
+ */
+static void generateAudio(Audio& audio, const double sampleRate, const double seconds)
+{
+    static constexpr const double kPi = 3.14159265358979323846;
+    static constexpr const uint32_t kNumHarmonics = 24;
+
+    audio.sampleRate = sampleRate;
+    audio.numFrames = static_cast<uint32_t>(sampleRate * seconds);
+
+    for (uint32_t c = 0; c < kNumChannels; ++c)
+    {
+        Random random(1 + c);
+        std::vector<float>& buffer(audio.channels[c]);
+        buffer.resize(audio.numFrames);
+
+        double phase = 0.0;
+        float noise = 0.f;
+
+        for (uint32_t i = 0; i < audio.numFrames; ++i)
+        {
+            const double t = i / sampleRate;
+            const double pitch = 150.0 + 40.0 * std::sin(2.0 * kPi * 0.7 * t) + 15.0 * std::sin(2.0 * kPi * 2.3 * t + c);
+            const double syllable = std::max(0.0, std::sin(2.0 * kPi * 3.1 * t + c * 0.5));
+
+            phase += pitch / sampleRate;
+            phase -= std::floor(phase);
+
+            // harmonics falling off with frequency, with a couple of broad formant bumps
+            double voice = 0.0;
+            for (uint32_t h = 1; h <= kNumHarmonics && pitch * h < sampleRate * 0.45; ++h)
+            {
+                const double freq = pitch * h;
+                const double formants = 1.0 + 2.0 * std::exp(-std::pow((freq - 700.0) / 300.0, 2.0))
+                                            + 1.5 * std::exp(-std::pow((freq - 1800.0) / 500.0, 2.0));
+                voice += std::sin(2.0 * kPi * phase * h) * formants / h;
+            }
+
+            // low-passed white noise, roughly 30dB below the voice
+            noise = noise * 0.8f + random.nextFloat() * 0.2f;
+
+            buffer[i] = static_cast<float>(voice * syllable * 0.15) + noise * 0.02f;
+        }
+    }
+}
+
+/**
+   Read a whole audio file as planar float audio.
+   Files with less channels than the plugin get their channels repeated, extra channels are ignored.
+ */
+static bool readAudioFile(Audio& audio, const char* const filename)
+{
+    AudioFileReader reader;
+    if (! reader.open(filename))
+        return false;
+
+    const AudioFileInfo& info(reader.getInfo());
+    DISTRHO_SAFE_ASSERT_RETURN(info.numFrames != 0 && info.numFrames < UINT32_MAX, false);
+
+    audio.sampleRate = info.sampleRate;
+    audio.numFrames = static_cast<uint32_t>(info.numFrames);
+
+    std::vector<std::vector<float>> fileChannels(info.numChannels);
+    std::vector<float*> buffers(info.numChannels);
+
+    for (uint32_t c = 0; c < info.numChannels; ++c)
+    {
+        fileChannels[c].resize(audio.numFrames);
+        buffers[c] = fileChannels[c].data();
+    }
+
+    if (reader.read(buffers.data(), audio.numFrames) != audio.numFrames)
+        return false;
+
+    for (uint32_t c = 0; c < kNumChannels; ++c)
+        audio.channels[c] = fileChannels[c % info.numChannels];
+
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Find the delay of @a output relative to @a input, as the lag of highest normalized cross-correlation.
+   Uses a quarter second window a bit into the audio, after the denoiser and resamplers have settled.
+   Returns -1 if the output is silent or too short to tell.
+ */
+static int32_t findObservedLatency(const std::vector<float>& input,
+                                   const std::vector<float>& output,
+                                   const double sampleRate,
+                                   const uint32_t maxLag)
+{
+    const uint32_t numFrames = static_cast<uint32_t>(input.size());
+    const uint32_t windowSize = static_cast<uint32_t>(sampleRate / 4);
+    const uint32_t start = std::min(static_cast<uint32_t>(sampleRate), numFrames / 4);
+
+    if (start + windowSize + maxLag > numFrames)
+        return -1;
+
+    double energy = 0.0;
+    for (uint32_t i = 0; i < windowSize; ++i)
+        energy += static_cast<double>(output[start + i]) * output[start + i];
+
+    int32_t bestLag = -1;
+    double bestScore = 0.0;
+
+    for (uint32_t lag = 0; lag <= maxLag; ++lag)
+    {
+        if (energy > 1e-9)
+        {
+            double sum = 0.0;
+            for (uint32_t i = 0; i < windowSize; ++i)
+                sum += static_cast<double>(input[start + i]) * output[start + lag + i];
+
+            const double score = sum / std::sqrt(energy);
+
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestLag = static_cast<int32_t>(lag);
+            }
+        }
+
+        // slide the output energy window by one frame
+        const float leaving = output[start + lag];
+        const float entering = output[start + lag + windowSize];
+        energy = std::max(0.0, energy - static_cast<double>(leaving) * leaving + static_cast<double>(entering) * entering);
+    }
+
+    return bestLag;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct Result {
+    double sampleRate;
+    uint32_t blockSize;
+    uint32_t numCallbacks;
+    double realtimeFactor;
+    double nsPerSample;
+    uint64_t callbackP50, callbackP99, callbackMax;
+    uint32_t reportedLatency;
+    int32_t observedLatency;
+    uint32_t deadlineMisses;
+};
+
+struct Options {
+    const char* inputFilename = nullptr;
+    double seconds = 10.0;
+    bool workerThread = false;
+    bool littleModel = false;
+    bool isaParity = false;
+    bool resumeCheck = false;
+    bool toleranceSet = false;
+    double toleranceDB = 0.0;
+};
+
+static Result runBenchmark(const Audio& audio, const uint32_t blockSize, const Options& options)
+{
+    Result result = {};
+    result.sampleRate = audio.sampleRate;
+    result.blockSize = blockSize;
+
+    // plugin is created as a host would, with the largest block size it will get
+    d_nextBufferSize = blockSize != 0 ? blockSize : kMaxRandomBlockSize;
+    d_nextSampleRate = audio.sampleRate;
+
+    PluginExporter plugin(nullptr, nullptr, nullptr, nullptr);
+
+   #ifndef SIMPLIFIED_NOOICE
+    // never mute, so the output can be correlated with the input
+    plugin.setParameterValue(kParamThreshold, 0.f);
+    plugin.setParameterValue(kParamWorkerThread, options.workerThread ? 1.f : 0.f);
+    plugin.setParameterValue(kParamLittleModel, options.littleModel ? 1.f : 0.f);
+   #endif
+
+    std::vector<float> outputs[kNumChannels];
+    for (uint32_t c = 0; c < kNumChannels; ++c)
+        outputs[c].resize(audio.numFrames);
+
+    std::vector<uint64_t> callbackTimes;
+    callbackTimes.reserve(blockSize != 0 ? audio.numFrames / blockSize + 1 : audio.numFrames);
+
+    Random random(blockSize + static_cast<uint32_t>(audio.sampleRate));
+    const float* inputPtrs[kNumChannels];
+    float* outputPtrs[kNumChannels];
+    uint64_t totalTime = 0;
+
+    plugin.activate();
+
+    // the worker thread needs real time to catch up, so callbacks are paced as a host would do
+    const std::chrono::steady_clock::time_point paceStart = std::chrono::steady_clock::now();
+
+    for (uint32_t pos = 0; pos < audio.numFrames;)
+    {
+        uint32_t frames = blockSize != 0 ? blockSize : 1 + random.next() % kMaxRandomBlockSize;
+        frames = std::min(frames, audio.numFrames - pos);
+
+        if (options.workerThread)
+            std::this_thread::sleep_until(paceStart + std::chrono::nanoseconds(
+                static_cast<int64_t>(pos / audio.sampleRate * 1e9)));
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            inputPtrs[c] = audio.channels[c].data() + pos;
+            outputPtrs[c] = outputs[c].data() + pos;
+        }
+
+        const uint64_t timeStart = getMonotonicTimeNs();
+        plugin.run(inputPtrs, outputPtrs, frames);
+        const uint64_t time = getMonotonicTimeNs() - timeStart;
+
+        callbackTimes.push_back(time);
+        totalTime += time;
+        pos += frames;
+    }
+
+   #ifndef SIMPLIFIED_NOOICE
+    result.deadlineMisses = static_cast<uint32_t>(plugin.getParameterValue(kParamDeadlineMisses) + 0.5f);
+   #endif
+
+    plugin.deactivate();
+
+    result.numCallbacks = static_cast<uint32_t>(callbackTimes.size());
+    result.realtimeFactor = totalTime != 0 ? audio.numFrames / audio.sampleRate * 1e9 / totalTime : 0.0;
+    result.nsPerSample = static_cast<double>(totalTime) / audio.numFrames / kNumChannels;
+
+    std::sort(callbackTimes.begin(), callbackTimes.end());
+    result.callbackP50 = callbackTimes[callbackTimes.size() / 2];
+    result.callbackP99 = callbackTimes[std::min(callbackTimes.size() - 1, callbackTimes.size() * 99 / 100)];
+    result.callbackMax = callbackTimes.back();
+
+    result.reportedLatency = plugin.getLatency();
+    result.observedLatency = findObservedLatency(audio.channels[0], outputs[0], audio.sampleRate,
+                                                 std::max(2048u, result.reportedLatency * 2));
+
+    return result;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct ParityRun {
+    int arch;
+    double realtimeFactor;
+    double nsPerSample;
+    std::vector<float> outputs[kNumChannels];
+    std::vector<float> vads;
+};
+
+struct ParityResult {
+    int arch;
+    double realtimeFactor;
+    double nsPerSample;
+    double speedup;
+    double maxAbsDiff;
+    double rmsDiff;
+    double maxVadDiff;
+};
+
+/**
+   Process @a audio with the RNNoise code path forced to @a arch, keeping output and per-block VAD.
+ */
+static void runParity(ParityRun& run, const Audio& audio, const int arch)
+{
+    run.arch = arch;
+    setRNNoiseArch(arch);
+
+    d_nextBufferSize = kParityBlockSize;
+    d_nextSampleRate = audio.sampleRate;
+
+    PluginExporter plugin(nullptr, nullptr, nullptr, nullptr);
+
+   #ifndef SIMPLIFIED_NOOICE
+    // never mute, so differences are not hidden, and have VAD reported
+    plugin.setParameterValue(kParamThreshold, 0.f);
+    plugin.setParameterValue(kParamEnableStats, 1.f);
+   #endif
+
+    for (uint32_t c = 0; c < kNumChannels; ++c)
+        run.outputs[c].resize(audio.numFrames);
+
+    run.vads.clear();
+    run.vads.reserve(audio.numFrames / kParityBlockSize + 1);
+
+    const float* inputPtrs[kNumChannels];
+    float* outputPtrs[kNumChannels];
+    uint64_t totalTime = 0;
+
+    plugin.activate();
+
+    for (uint32_t pos = 0; pos < audio.numFrames;)
+    {
+        const uint32_t frames = std::min(kParityBlockSize, audio.numFrames - pos);
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            inputPtrs[c] = audio.channels[c].data() + pos;
+            outputPtrs[c] = run.outputs[c].data() + pos;
+        }
+
+        const uint64_t timeStart = getMonotonicTimeNs();
+        plugin.run(inputPtrs, outputPtrs, frames);
+        totalTime += getMonotonicTimeNs() - timeStart;
+
+       #ifndef SIMPLIFIED_NOOICE
+        run.vads.push_back(plugin.getParameterValue(kParamCurrentVAD) * 0.01f);
+       #endif
+        pos += frames;
+    }
+
+    plugin.deactivate();
+
+    run.realtimeFactor = totalTime != 0 ? audio.numFrames / audio.sampleRate * 1e9 / totalTime : 0.0;
+    run.nsPerSample = static_cast<double>(totalTime) / audio.numFrames / kNumChannels;
+
+    setRNNoiseArch(kRNNoiseArchAuto);
+}
+
+/**
+   Compare a parity run against the reference one, which uses the generic code path.
+ */
+static ParityResult compareParity(const ParityRun& run, const ParityRun& reference, const uint32_t numFrames)
+{
+    ParityResult result = {};
+    result.arch = run.arch;
+    result.realtimeFactor = run.realtimeFactor;
+    result.nsPerSample = run.nsPerSample;
+    result.speedup = run.nsPerSample > 0.0 ? reference.nsPerSample / run.nsPerSample : 0.0;
+
+    double sumSquares = 0.0;
+
+    for (uint32_t c = 0; c < kNumChannels; ++c)
+    {
+        for (uint32_t i = 0; i < numFrames; ++i)
+        {
+            const double diff = std::abs(static_cast<double>(run.outputs[c][i]) - reference.outputs[c][i]);
+            result.maxAbsDiff = std::max(result.maxAbsDiff, diff);
+            sumSquares += diff * diff;
+        }
+    }
+
+    result.rmsDiff = std::sqrt(sumSquares / numFrames / kNumChannels);
+
+    for (size_t i = 0; i < run.vads.size(); ++i)
+        result.maxVadDiff = std::max(result.maxVadDiff, static_cast<double>(std::abs(run.vads[i] - reference.vads[i])));
+
+    return result;
+}
+
+static double toDB(const double value)
+{
+    return 20.0 * std::log10(value);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static void printJsonString(const char* const str)
+{
+    std::putchar('"');
+    for (const char* s = str; *s != '\0'; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+            std::printf("\\%c", *s);
+        else if (static_cast<uint8_t>(*s) < 0x20)
+            std::printf("\\u%04x", *s);
+        else
+            std::putchar(*s);
+    }
+    std::putchar('"');
+}
+
+static void printResults(const std::vector<Result>& results, const Options& options, const PluginExporter& plugin)
+{
+    const uint32_t version = plugin.getVersion();
+
+    std::printf("{\n");
+    std::printf("  \"plugin\": \"%s\",\n", plugin.getLabel());
+    std::printf("  \"version\": \"%u.%u.%u\",\n", (version >> 16) & 0xff, (version >> 8) & 0xff, version & 0xff);
+    std::printf("  \"channels\": %u,\n", kNumChannels);
+    std::printf("  \"input\": ");
+    printJsonString(options.inputFilename != nullptr ? options.inputFilename : "generated");
+    std::printf(",\n");
+    std::printf("  \"worker_thread\": %s,\n", options.workerThread ? "true" : "false");
+    std::printf("  \"little_model\": %s,\n", options.littleModel ? "true" : "false");
+    std::printf("  \"results\": [\n");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r(results[i]);
+
+        std::printf("    {\n");
+        std::printf("      \"sample_rate\": %.0f,\n", r.sampleRate);
+
+        if (r.blockSize != 0)
+            std::printf("      \"block_size\": %u,\n", r.blockSize);
+        else
+            std::printf("      \"block_size\": \"random\",\n");
+
+        std::printf("      \"callbacks\": %u,\n", r.numCallbacks);
+        std::printf("      \"rt_factor\": %.3f,\n", r.realtimeFactor);
+        std::printf("      \"ns_per_sample\": %.3f,\n", r.nsPerSample);
+        std::printf("      \"callback_ns\": { \"p50\": %llu, \"p99\": %llu, \"max\": %llu },\n",
+                    static_cast<unsigned long long>(r.callbackP50),
+                    static_cast<unsigned long long>(r.callbackP99),
+                    static_cast<unsigned long long>(r.callbackMax));
+
+        std::printf("      \"deadline_misses\": %u,\n", r.deadlineMisses);
+
+        if (r.observedLatency >= 0)
+            std::printf("      \"latency\": { \"reported\": %u, \"observed\": %d }\n",
+                        r.reportedLatency, r.observedLatency);
+        else
+            std::printf("      \"latency\": { \"reported\": %u, \"observed\": null }\n", r.reportedLatency);
+
+        std::printf("    }%s\n", i + 1 != results.size() ? "," : "");
+    }
+
+    std::printf("  ]\n");
+    std::printf("}\n");
+}
+
+static void printDB(const char* const name, const double value, const char* const separator)
+{
+    // identical output has no level to speak of
+    if (value > 0.0)
+        std::printf("      \"%s\": %.2f%s\n", name, toDB(value), separator);
+    else
+        std::printf("      \"%s\": null%s\n", name, separator);
+}
+
+static void printParityResults(const std::vector<ParityResult>& results,
+                               const Options& options,
+                               const PluginExporter& plugin,
+                               const double sampleRate)
+{
+    const uint32_t version = plugin.getVersion();
+
+    std::printf("{\n");
+    std::printf("  \"plugin\": \"%s\",\n", plugin.getLabel());
+    std::printf("  \"version\": \"%u.%u.%u\",\n", (version >> 16) & 0xff, (version >> 8) & 0xff, version & 0xff);
+    std::printf("  \"channels\": %u,\n", kNumChannels);
+    std::printf("  \"input\": ");
+    printJsonString(options.inputFilename != nullptr ? options.inputFilename : "generated");
+    std::printf(",\n");
+    std::printf("  \"sample_rate\": %.0f,\n", sampleRate);
+    std::printf("  \"block_size\": %u,\n", kParityBlockSize);
+    std::printf("  \"detected_isa\": \"%s\",\n", getRNNoiseArchName(getRNNoiseArchDetected()));
+    std::printf("  \"reference_isa\": \"%s\",\n", getRNNoiseArchName(kRNNoiseArchGeneric));
+    std::printf("  \"results\": [\n");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const ParityResult& r(results[i]);
+
+        std::printf("    {\n");
+        std::printf("      \"isa\": \"%s\",\n", getRNNoiseArchName(r.arch));
+        std::printf("      \"rt_factor\": %.3f,\n", r.realtimeFactor);
+        std::printf("      \"ns_per_sample\": %.3f,\n", r.nsPerSample);
+        std::printf("      \"speedup\": %.3f,\n", r.speedup);
+        std::printf("      \"max_abs_diff\": %g,\n", r.maxAbsDiff);
+        printDB("max_diff_db", r.maxAbsDiff, ",");
+        printDB("rms_diff_db", r.rmsDiff, ",");
+        std::printf("      \"max_vad_diff\": %.4f\n", r.maxVadDiff);
+        std::printf("    }%s\n", i + 1 != results.size() ? "," : "");
+    }
+
+    std::printf("  ]\n");
+    std::printf("}\n");
+}
+
+struct ResumeResult {
+    uint32_t numResumes;
+    uint32_t checkedFrames;
+    uint32_t unprocessedFrames;
+    uint32_t skippedFrames;
+};
+
+static void printResumeResult(const ResumeResult& result, const Options& options, const PluginExporter& plugin)
+{
+    const uint32_t version = plugin.getVersion();
+
+    std::printf("{\n");
+    std::printf("  \"plugin\": \"%s\",\n", plugin.getLabel());
+    std::printf("  \"version\": \"%u.%u.%u\",\n", (version >> 16) & 0xff, (version >> 8) & 0xff, version & 0xff);
+    std::printf("  \"channels\": %u,\n", kNumChannels);
+    std::printf("  \"input\": ");
+    printJsonString(options.inputFilename != nullptr ? options.inputFilename : "generated");
+    std::printf(",\n");
+    std::printf("  \"worker_thread\": %s,\n", options.workerThread ? "true" : "false");
+    std::printf("  \"little_model\": %s,\n", options.littleModel ? "true" : "false");
+    std::printf("  \"resumes\": %u,\n", result.numResumes);
+    std::printf("  \"skipped_frames\": %u,\n", result.skippedFrames);
+    std::printf("  \"checked_frames\": %u,\n", result.checkedFrames);
+    std::printf("  \"unprocessed_frames\": %u\n", result.unprocessedFrames);
+    std::printf("}\n");
+}
+
+static void printUsage(const char* const name)
+{
+    std::fprintf(stderr, "Usage: %s [options]\n"
+                         "  --input <file.wav>      use audio from a file instead of generated audio\n"
+                         "  --seconds <value>       length of generated audio, defaults to 10\n"
+                         "  --worker                run inference on the worker thread, paced in real time\n"
+                         "  --little                use the little builtin model\n"
+                         "  --isa-parity            run every RNNoise code path supported here (generic, sse4.1, avx2)\n"
+                         "                          and compare their speed and output against the generic one\n"
+                         "  --tolerance-db <value>  with --isa-parity, fail if any output or voice detection probability\n"
+                         "                          differs by more than this\n"
+                         "  --resume-check          cut silence into the audio, skip inference during it and fail if\n"
+                         "                          unprocessed input reaches the output once inference resumes\n",
+                 name);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Run @a audio through every code path supported here, print how they compare and check the tolerance if set.
+ */
+static int runParityMain(const Audio& audio, const Options& options)
+{
+    std::vector<ParityRun> runs;
+    runs.reserve(ARRAY_SIZE(kRNNoiseArchs));
+
+    for (const RNNoiseArch arch : kRNNoiseArchs)
+    {
+        if (arch > getRNNoiseArchDetected())
+            continue;
+
+        std::fprintf(stderr, "Running %s code path...\n", getRNNoiseArchName(arch));
+
+        runs.resize(runs.size() + 1);
+        runParity(runs.back(), audio, arch);
+    }
+
+    std::vector<ParityResult> results;
+    bool ok = true;
+
+    for (const ParityRun& run : runs)
+    {
+        results.push_back(compareParity(run, runs.front(), audio.numFrames));
+
+        const ParityResult& r(results.back());
+
+        if (! options.toleranceSet)
+            continue;
+
+        if (r.maxAbsDiff > 0.0 && toDB(r.maxAbsDiff) > options.toleranceDB)
+        {
+            std::fprintf(stderr, "%s output differs by %.2fdB, over the %.2fdB tolerance\n",
+                         getRNNoiseArchName(r.arch), toDB(r.maxAbsDiff), options.toleranceDB);
+            ok = false;
+        }
+
+        // the mute gate acts on voice detection, so it must agree as closely as the audio does
+        if (r.maxVadDiff > 0.0 && toDB(r.maxVadDiff) > options.toleranceDB)
+        {
+            std::fprintf(stderr, "%s voice detection differs by %.2fdB, over the %.2fdB tolerance\n",
+                         getRNNoiseArchName(r.arch), toDB(r.maxVadDiff), options.toleranceDB);
+            ok = false;
+        }
+    }
+
+    d_nextBufferSize = kParityBlockSize;
+    d_nextSampleRate = audio.sampleRate;
+    const PluginExporter plugin(nullptr, nullptr, nullptr, nullptr);
+
+    printParityResults(results, options, plugin, audio.sampleRate);
+    return ok ? 0 : 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+#ifndef SIMPLIFIED_NOOICE
+/**
+   Replace the first half of every second of @a audio with digital silence.
+   Returns the frames where input comes back after each gap.
+ */
+static std::vector<uint32_t> addSilenceGaps(Audio& audio)
+{
+    const uint32_t second = d_roundToUnsignedInt(audio.sampleRate);
+    const uint32_t gap = d_roundToUnsignedInt(audio.sampleRate * kResumeGapSeconds);
+    std::vector<uint32_t> resumes;
+
+    for (uint32_t start = 0; start + gap < audio.numFrames; start += second)
+    {
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+            std::fill(audio.channels[c].begin() + start, audio.channels[c].begin() + start + gap, 0.f);
+
+        resumes.push_back(start + gap);
+    }
+
+    return resumes;
+}
+
+/**
+   Run @a audio with silence gaps through the plugin, skipping inference while silent.
+   Output right after each resume must always be denoised, any frame that comes out exactly as it went in
+   means the network was bypassed and unprocessed input reached the listener.
+ */
+static int runResumeCheckMain(Audio audio, const Options& options)
+{
+    const std::vector<uint32_t> resumes(addSilenceGaps(audio));
+
+    d_nextBufferSize = kParityBlockSize;
+    d_nextSampleRate = audio.sampleRate;
+
+    PluginExporter plugin(nullptr, nullptr, nullptr, nullptr);
+
+    // never mute, so all output comes from the network
+    plugin.setParameterValue(kParamThreshold, 0.f);
+    plugin.setParameterValue(kParamSkipInference, 1.f);
+    plugin.setParameterValue(kParamWorkerThread, options.workerThread ? 1.f : 0.f);
+    plugin.setParameterValue(kParamLittleModel, options.littleModel ? 1.f : 0.f);
+
+    std::vector<float> outputs[kNumChannels];
+    for (uint32_t c = 0; c < kNumChannels; ++c)
+        outputs[c].resize(audio.numFrames);
+
+    const float* inputPtrs[kNumChannels];
+    float* outputPtrs[kNumChannels];
+
+    std::fprintf(stderr, "Running resume check...\n");
+
+    plugin.activate();
+
+    const std::chrono::steady_clock::time_point paceStart = std::chrono::steady_clock::now();
+
+    for (uint32_t pos = 0; pos < audio.numFrames;)
+    {
+        const uint32_t frames = std::min(kParityBlockSize, audio.numFrames - pos);
+
+        if (options.workerThread)
+            std::this_thread::sleep_until(paceStart + std::chrono::nanoseconds(
+                static_cast<int64_t>(pos / audio.sampleRate * 1e9)));
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            inputPtrs[c] = audio.channels[c].data() + pos;
+            outputPtrs[c] = outputs[c].data() + pos;
+        }
+
+        plugin.run(inputPtrs, outputPtrs, frames);
+        pos += frames;
+    }
+
+    ResumeResult result = {};
+    result.numResumes = static_cast<uint32_t>(resumes.size());
+    result.skippedFrames = static_cast<uint32_t>(plugin.getParameterValue(kParamSkippedFrames) + 0.5f);
+
+    plugin.deactivate();
+
+    const uint32_t latency = plugin.getLatency();
+    const uint32_t checkFrames = d_roundToUnsignedInt(kResumeCheckBlocks * kParityBlockSize * audio.sampleRate / 48000.0);
+
+    for (const uint32_t resume : resumes)
+    {
+        for (uint32_t i = resume; i < resume + checkFrames && i + latency < audio.numFrames; ++i)
+        {
+            for (uint32_t c = 0; c < kNumChannels; ++c)
+            {
+                const float in = audio.channels[c][i];
+
+                if (in == 0.f)
+                    continue;
+
+                ++result.checkedFrames;
+
+                if (outputs[c][i + latency] == in)
+                    ++result.unprocessedFrames;
+            }
+        }
+    }
+
+    printResumeResult(result, options, plugin);
+
+    if (result.skippedFrames == 0)
+    {
+        std::fprintf(stderr, "Inference was never skipped, nothing was checked\n");
+        return 1;
+    }
+
+    if (result.unprocessedFrames != 0)
+    {
+        std::fprintf(stderr, "%u frames of unprocessed input reached the output after resuming\n",
+                     result.unprocessedFrames);
+        return 1;
+    }
+
+    return 0;
+}
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+int main(int argc, char* argv[])
+{
+    USE_NAMESPACE_DISTRHO;
+
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+        {
+            options.inputFilename = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            options.seconds = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--worker") == 0)
+        {
+            options.workerThread = true;
+        }
+        else if (std::strcmp(argv[i], "--little") == 0)
+        {
+            options.littleModel = true;
+        }
+        else if (std::strcmp(argv[i], "--isa-parity") == 0)
+        {
+            options.isaParity = true;
+        }
+        else if (std::strcmp(argv[i], "--tolerance-db") == 0 && i + 1 < argc)
+        {
+            options.toleranceSet = true;
+            options.toleranceDB = std::atof(argv[++i]);
+        }
+       #ifndef SIMPLIFIED_NOOICE
+        else if (std::strcmp(argv[i], "--resume-check") == 0)
+        {
+            options.resumeCheck = true;
+        }
+       #endif
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.seconds <= 0.0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Audio> inputs;
+
+    if (options.inputFilename != nullptr)
+    {
+        inputs.resize(1);
+
+        if (! readAudioFile(inputs[0], options.inputFilename))
+        {
+            std::fprintf(stderr, "Failed to read '%s'\n", options.inputFilename);
+            return 1;
+        }
+    }
+    else if (options.isaParity || options.resumeCheck)
+    {
+        // both only look at the network, resampling would just add noise to the comparison
+        inputs.resize(1);
+        generateAudio(inputs[0], kSampleRates[0], options.seconds);
+    }
+    else
+    {
+        inputs.resize(ARRAY_SIZE(kSampleRates));
+
+        for (size_t i = 0; i < ARRAY_SIZE(kSampleRates); ++i)
+            generateAudio(inputs[i], kSampleRates[i], options.seconds);
+    }
+
+    if (options.isaParity)
+        return runParityMain(inputs[0], options);
+
+   #ifndef SIMPLIFIED_NOOICE
+    if (options.resumeCheck)
+        return runResumeCheckMain(inputs[0], options);
+   #endif
+
+    std::vector<Result> results;
+
+    for (const Audio& audio : inputs)
+    {
+        for (const uint32_t blockSize : kBlockSizes)
+        {
+            if (blockSize != 0)
+                std::fprintf(stderr, "Running at %.0fHz with block size %u...\n", audio.sampleRate, blockSize);
+            else
+                std::fprintf(stderr, "Running at %.0fHz with random block sizes...\n", audio.sampleRate);
+
+            results.push_back(runBenchmark(audio, blockSize, options));
+        }
+    }
+
+    // an idle instance for the plugin details
+    d_nextBufferSize = kMaxRandomBlockSize;
+    d_nextSampleRate = inputs[0].sampleRate;
+    const PluginExporter plugin(nullptr, nullptr, nullptr, nullptr);
+
+    printResults(results, options, plugin);
+    return 0;
+}
@@ -0,0 +1,298 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// standalone benchmark of the multi-stream batch API, built the same way as the mapi shared library.
+// the same streams are processed with an increasing number of threads, showing how throughput scales with cores.
+// results are written as JSON to stdout, so they can be stored and compared over time.
+
+#include "DspTiming.hpp"
+#include "MapiBatch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+// distinct signals generated, streams take turns using them so memory use does not grow with the stream count
+static constexpr const uint32_t kNumSources = 8;
+
+// small deterministic generator, so every run gets the same audio
+struct Random {
+    uint32_t state;
+
+    explicit Random(const uint32_t seed) noexcept
+        : state(seed) {}
+
+    uint32_t next() noexcept
+    {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+
+    float nextFloat() noexcept
+    {
+        return static_cast<float>(next() >> 8) / static_cast<float>(1 << 24) * 2.f - 1.f;
+    }
+};
+
+struct Audio {
+    uint32_t numFrames = 0;
+    std::vector<float> sources[kNumSources];
+};
+
+/**
+   Generate something resembling speech over background noise, a different voice for each source.
+ */
+static void generateAudio(Audio& audio, const double sampleRate, const double seconds)
+{
+    static constexpr const double kPi = 3.14159265358979323846;
+
+    audio.numFrames = static_cast<uint32_t>(sampleRate * seconds);
+
+    for (uint32_t k = 0; k < kNumSources; ++k)
+    {
+        Random random(1 + k);
+        std::vector<float>& buffer(audio.sources[k]);
+        buffer.resize(audio.numFrames);
+
+        double phase = 0.0;
+        float noise = 0.f;
+
+        for (uint32_t i = 0; i < audio.numFrames; ++i)
+        {
+            const double t = i / sampleRate;
+            const double pitch = 120.0 + 10.0 * k + 40.0 * std::sin(2.0 * kPi * 0.7 * t + k);
+            const double syllable = std::max(0.0, std::sin(2.0 * kPi * (2.5 + 0.2 * k) * t));
+
+            phase += pitch / sampleRate;
+            phase -= std::floor(phase);
+
+            double voice = 0.0;
+            for (uint32_t h = 1; h <= 16 && pitch * h < sampleRate * 0.45; ++h)
+                voice += std::sin(2.0 * kPi * phase * h) / h;
+
+            // low-passed white noise, roughly 30dB below the voice
+            noise = noise * 0.8f + random.nextFloat() * 0.2f;
+
+            buffer[i] = static_cast<float>(voice * syllable * 0.15) + noise * 0.02f;
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct Options {
+    double sampleRate = 48000.0;
+    double seconds = 10.0;
+    uint32_t numStreams = 64;
+    uint32_t maxThreads = 0;
+    uint32_t tickFrames = 480;
+    bool interleaved = false;
+};
+
+struct Result {
+    uint32_t numThreads;
+    double realtimeStreams;
+    double worstTickLoad;
+    double speedup;
+    double efficiency;
+};
+
+static bool runBenchmark(Result& result, const Audio& audio, const uint32_t numThreads, const Options& options)
+{
+    const uint32_t numStreams = options.numStreams;
+    const uint32_t tickFrames = options.tickFrames;
+
+    const mapi_renooice_batch_t batch = mapi_renooice_batch_create(d_roundToUnsignedInt(options.sampleRate),
+                                                                   numStreams, numThreads, tickFrames);
+    if (batch == nullptr)
+        return false;
+
+    // output is only kept for a single tick, nothing looks at it
+    std::vector<float> outputs(numStreams * tickFrames);
+    std::vector<float> interleavedIn, interleavedOut;
+    std::vector<const float*> inputPtrs(numStreams);
+    std::vector<float*> outputPtrs(numStreams);
+
+    for (uint32_t s = 0; s < numStreams; ++s)
+        outputPtrs[s] = outputs.data() + s * tickFrames;
+
+    if (options.interleaved)
+    {
+        interleavedIn.resize(numStreams * tickFrames);
+        interleavedOut.resize(numStreams * tickFrames);
+    }
+
+    const uint64_t tickBudget = static_cast<uint64_t>(tickFrames / options.sampleRate * 1e9);
+    uint64_t totalTime = 0, worstTime = 0;
+
+    for (uint32_t pos = 0; pos + tickFrames <= audio.numFrames; pos += tickFrames)
+    {
+        uint64_t timeStart;
+
+        if (options.interleaved)
+        {
+            for (uint32_t i = 0; i < tickFrames; ++i)
+                for (uint32_t s = 0; s < numStreams; ++s)
+                    interleavedIn[i * numStreams + s] = audio.sources[s % kNumSources][pos + i];
+
+            timeStart = getMonotonicTimeNs();
+            mapi_renooice_batch_process_interleaved(batch, interleavedIn.data(), interleavedOut.data(), tickFrames);
+        }
+        else
+        {
+            for (uint32_t s = 0; s < numStreams; ++s)
+                inputPtrs[s] = audio.sources[s % kNumSources].data() + pos;
+
+            timeStart = getMonotonicTimeNs();
+            mapi_renooice_batch_process(batch, inputPtrs.data(), outputPtrs.data(), tickFrames);
+        }
+
+        const uint64_t tickTime = getMonotonicTimeNs() - timeStart;
+        totalTime += tickTime;
+        worstTime = std::max(worstTime, tickTime);
+    }
+
+    mapi_renooice_batch_destroy(batch);
+
+    const double seconds = (audio.numFrames / tickFrames) * tickFrames / options.sampleRate;
+
+    result.numThreads = numThreads;
+    result.realtimeStreams = totalTime != 0 ? numStreams * seconds * 1e9 / totalTime : 0.0;
+    result.worstTickLoad = tickBudget != 0 ? static_cast<double>(worstTime) / tickBudget : 0.0;
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static void printResults(const std::vector<Result>& results, const Options& options)
+{
+    std::printf("{\n");
+    std::printf("  \"sample_rate\": %.0f,\n", options.sampleRate);
+    std::printf("  \"seconds\": %.1f,\n", options.seconds);
+    std::printf("  \"streams\": %u,\n", options.numStreams);
+    std::printf("  \"tick_frames\": %u,\n", options.tickFrames);
+    std::printf("  \"interleaved\": %s,\n", options.interleaved ? "true" : "false");
+    std::printf("  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    std::printf("  \"results\": [\n");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r(results[i]);
+
+        std::printf("    {\n");
+        std::printf("      \"threads\": %u,\n", r.numThreads);
+        std::printf("      \"realtime_streams\": %.1f,\n", r.realtimeStreams);
+        std::printf("      \"worst_tick_load\": %.3f,\n", r.worstTickLoad);
+        std::printf("      \"speedup\": %.2f,\n", r.speedup);
+        std::printf("      \"efficiency\": %.2f\n", r.efficiency);
+        std::printf("    }%s\n", i + 1 != results.size() ? "," : "");
+    }
+
+    std::printf("  ]\n");
+    std::printf("}\n");
+}
+
+static void printUsage(const char* const name)
+{
+    std::fprintf(stderr, "Usage: %s [options]\n"
+                         "  --streams <value>     number of streams in the batch, defaults to 64\n"
+                         "  --threads <value>     most threads to scale up to, defaults to one per CPU core\n"
+                         "  --tick <value>        frames per tick, defaults to 480\n"
+                         "  --seconds <value>     length of generated audio, defaults to 10\n"
+                         "  --sample-rate <value> stream sample rate, defaults to 48000\n"
+                         "  --interleaved         use interleaved buffers instead of planar ones\n",
+                 name);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+int main(int argc, char* argv[])
+{
+    USE_NAMESPACE_DISTRHO;
+
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--streams") == 0 && i + 1 < argc)
+        {
+            options.numStreams = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            options.maxThreads = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--tick") == 0 && i + 1 < argc)
+        {
+            options.tickFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            options.seconds = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc)
+        {
+            options.sampleRate = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--interleaved") == 0)
+        {
+            options.interleaved = true;
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.maxThreads == 0)
+        options.maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (options.numStreams == 0 || options.tickFrames == 0 || options.seconds <= 0.0 || options.sampleRate < 8000.0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Audio audio;
+    generateAudio(audio, options.sampleRate, options.seconds);
+
+    // thread counts doubling up to the most requested, a batch never uses more threads than streams
+    const uint32_t maxThreads = std::min(options.maxThreads, options.numStreams);
+    std::vector<Result> results;
+
+    for (uint32_t numThreads = 1;; numThreads = std::min(numThreads * 2, maxThreads))
+    {
+        std::fprintf(stderr, "Running %u streams on %u threads...\n", options.numStreams, numThreads);
+
+        Result result = {};
+        if (! runBenchmark(result, audio, numThreads, options))
+        {
+            std::fprintf(stderr, "Failed to create batch\n");
+            return 1;
+        }
+
+        result.speedup = results.empty() || results[0].realtimeStreams == 0.0
+                       ? 1.0
+                       : result.realtimeStreams / results[0].realtimeStreams;
+        result.efficiency = result.speedup / numThreads;
+        results.push_back(result);
+
+        if (numThreads == maxThreads)
+            break;
+    }
+
+    printResults(results, options);
+    return 0;
+}
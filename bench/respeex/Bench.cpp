@@ -0,0 +1,436 @@
+/*
+ * Re:Speex
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// standalone benchmark of the echo canceller test plugin, running it through DPF without a host.
+// every echo canceller block size is run on the same simulated echo, showing CPU cost against latency.
+// the plugin runs speex at the host rate, which can be set to compare the cost of e.g. 16kHz VoIP against 48kHz.
+// the conversion to and from 16-bit samples done per echo block is timed on its own too, scalar versus vector.
+// with delay estimation enabled, audio is paced in real time so the background estimator can keep up.
+// results are written as JSON to stdout, so they can be stored and compared over time.
+
+#include "src/DistrhoPlugin.cpp"
+#include "src/DistrhoUtils.cpp"
+
+#include "DspTiming.hpp"
+#include "Int16Convert.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+// simulated echo path, a decaying reflection pattern after a bulk delay (set through options), in milliseconds
+static constexpr const double kEchoLengthMs = 50.0;
+
+// echo attenuation is measured on the last part of the audio, once the filter has converged
+static constexpr const double kConvergedFraction = 0.5;
+
+// conversions are timed a few times over the whole audio, keeping the fastest
+static constexpr const uint32_t kConvertRounds = 5;
+
+// --------------------------------------------------------------------------------------------------------------------
+
+// small deterministic generator, so every run gets the same audio
+struct Random {
+    uint32_t state;
+
+    explicit Random(const uint32_t seed) noexcept
+        : state(seed) {}
+
+    uint32_t next() noexcept
+    {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+
+    float nextFloat() noexcept
+    {
+        return static_cast<float>(next() >> 8) / static_cast<float>(1 << 24) * 2.f - 1.f;
+    }
+};
+
+struct Audio {
+    uint32_t numFrames = 0;
+    std::vector<float> mic;
+    std::vector<float> reference;
+};
+
+/**
+   Generate far-end speech-like audio as reference, and a mic signal with its echo over some background noise.
+   The echo comes @a echoDelay frames after the reference.
+ */
+static void generateAudio(Audio& audio, const double sampleRate, const double seconds, const uint32_t echoDelay)
+{
+    static constexpr const double kPi = 3.14159265358979323846;
+
+    audio.numFrames = static_cast<uint32_t>(sampleRate * seconds);
+    audio.mic.resize(audio.numFrames);
+    audio.reference.resize(audio.numFrames);
+
+    Random random(1);
+    double phase = 0.0;
+
+    // syllables and pauses of random length, as a regular pattern would make the echo delay ambiguous
+    double syllable = 0.0, syllableTarget = 0.0;
+    uint32_t syllableEnd = 0;
+
+    for (uint32_t i = 0; i < audio.numFrames; ++i)
+    {
+        const double t = i / sampleRate;
+        const double pitch = 140.0 + 50.0 * std::sin(2.0 * kPi * 0.6 * t);
+
+        if (i >= syllableEnd)
+        {
+            syllableTarget = syllableTarget == 0.0 ? 0.5 + 0.5 * std::abs(random.nextFloat()) : 0.0;
+            syllableEnd = i + static_cast<uint32_t>(sampleRate * (0.08 + 0.2 * std::abs(random.nextFloat())));
+        }
+
+        syllable += (syllableTarget - syllable) * 96.0 / sampleRate;
+
+        phase += pitch / sampleRate;
+        phase -= std::floor(phase);
+
+        double voice = 0.0;
+        for (uint32_t h = 1; h <= 16; ++h)
+            voice += std::sin(2.0 * kPi * phase * h) / h;
+
+        audio.reference[i] = static_cast<float>(voice * syllable * 0.2) + random.nextFloat() * 0.01f;
+    }
+
+    // same echo path at every rate, its gain scaled so the echo level stays the same too
+    const uint32_t echoLength = d_roundToUnsignedInt(kEchoLengthMs * 0.001 * sampleRate);
+    const float echoGain = 0.3f * std::sqrt(48000.f / static_cast<float>(sampleRate));
+
+    std::vector<float> impulse(echoLength);
+    for (uint32_t i = 0; i < echoLength; ++i)
+        impulse[i] = random.nextFloat() * echoGain * std::exp(-static_cast<float>(i) / (echoLength / 6));
+
+    for (uint32_t i = 0; i < audio.numFrames; ++i)
+    {
+        float echo = 0.f;
+        for (uint32_t j = 0; j < echoLength && j + echoDelay <= i; ++j)
+            echo += impulse[j] * audio.reference[i - echoDelay - j];
+
+        audio.mic[i] = echo + random.nextFloat() * 0.001f;
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct Options {
+    double sampleRate = 48000.0;
+    double seconds = 10.0;
+    uint32_t blockSize = 480;
+    float tailMs = 100.f;
+    float echoDelayMs = 20.f;
+    bool delayEstimation = false;
+    float alignedTailMs = 40.f;
+};
+
+struct Result {
+    uint32_t frameSizeMs;
+    uint32_t latency;
+    double realtimeFactor;
+    double nsPerSample;
+    double erleDB;
+    float estimatedDelayMs;
+    float effectiveTailMs;
+};
+
+static Result runBenchmark(const Audio& audio, const uint32_t frameSizeMs, const Options& options)
+{
+    Result result = {};
+    result.frameSizeMs = frameSizeMs;
+
+    d_nextBufferSize = options.blockSize;
+    d_nextSampleRate = options.sampleRate;
+
+    PluginExporter plugin(nullptr, nullptr, nullptr, nullptr);
+    plugin.setParameterValue(kParamEchoFrameSize, frameSizeMs);
+    plugin.setParameterValue(kParamEchoTail, options.tailMs);
+    plugin.setParameterValue(kParamDelayEstimation, options.delayEstimation ? 1.f : 0.f);
+    plugin.setParameterValue(kParamAlignedTail, options.alignedTailMs);
+
+    std::vector<float> output(audio.numFrames);
+    uint64_t totalTime = 0;
+
+    plugin.activate();
+
+    const std::chrono::steady_clock::time_point paceStart = std::chrono::steady_clock::now();
+
+    for (uint32_t pos = 0; pos < audio.numFrames;)
+    {
+        const uint32_t frames = std::min(options.blockSize, audio.numFrames - pos);
+
+        if (options.delayEstimation)
+            std::this_thread::sleep_until(paceStart + std::chrono::nanoseconds(
+                static_cast<int64_t>(pos / options.sampleRate * 1e9)));
+        const float* inputPtrs[2] = { audio.mic.data() + pos, audio.reference.data() + pos };
+        float* outputPtrs[1] = { output.data() + pos };
+
+        const uint64_t timeStart = getMonotonicTimeNs();
+        plugin.run(inputPtrs, outputPtrs, frames);
+        totalTime += getMonotonicTimeNs() - timeStart;
+
+        pos += frames;
+    }
+
+    result.estimatedDelayMs = plugin.getParameterValue(kParamEstimatedDelay);
+    result.effectiveTailMs = plugin.getParameterValue(kParamEffectiveTail);
+
+    plugin.deactivate();
+
+    result.latency = plugin.getLatency();
+    result.realtimeFactor = totalTime != 0 ? audio.numFrames / options.sampleRate * 1e9 / totalTime : 0.0;
+    result.nsPerSample = static_cast<double>(totalTime) / audio.numFrames;
+
+    // echo return loss enhancement, mic energy over output energy, output aligned by the reported latency
+    const uint32_t start = static_cast<uint32_t>(audio.numFrames * kConvergedFraction);
+    double micEnergy = 0.0, outEnergy = 0.0;
+
+    for (uint32_t i = start; i + result.latency < audio.numFrames; ++i)
+    {
+        micEnergy += static_cast<double>(audio.mic[i]) * audio.mic[i];
+        outEnergy += static_cast<double>(output[i + result.latency]) * output[i + result.latency];
+    }
+
+    result.erleDB = outEnergy > 0.0 ? 10.0 * std::log10(micEnergy / outEnergy) : 0.0;
+
+    return result;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct ConvertResult {
+    uint32_t frameSize;
+    double scalarNsPerBlock;
+    double vectorNsPerBlock;
+    bool identical;
+};
+
+/**
+   Convert one echo block the way it was done before vector kernels, sample by sample.
+   Mic and reference go to 16-bit, and the mic samples back to float in place of the echo canceller output.
+ */
+static void convertBlockScalar(int16_t* const mic16, int16_t* const ref16, float* const out,
+                               const float* const mic, const float* const ref, const uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; ++i)
+    {
+        mic16[i] = float16(mic[i]);
+        ref16[i] = float16(ref[i]);
+    }
+
+    for (uint32_t i = 0; i < frames; ++i)
+        out[i] = static_cast<float>(mic16[i]) * (1.f / 32767.f);
+}
+
+static void convertBlockVector(int16_t* const mic16, int16_t* const ref16, float* const out,
+                               const float* const mic, const float* const ref, const uint32_t frames)
+{
+    convertFloatToInt16(mic16, mic, frames);
+    convertFloatToInt16(ref16, ref, frames);
+    convertInt16ToFloat(out, mic16, frames);
+}
+
+static ConvertResult runConvertBenchmark(const Audio& audio, const uint32_t frameSize)
+{
+    typedef void (*ConvertFunction)(int16_t*, int16_t*, float*, const float*, const float*, uint32_t);
+
+    ConvertResult result = {};
+    result.frameSize = frameSize;
+
+    const uint32_t numBlocks = audio.numFrames / frameSize;
+    std::vector<int16_t> mic16[2], ref16[2];
+    std::vector<float> out[2];
+
+    for (uint32_t k = 0; k < 2; ++k)
+    {
+        mic16[k].resize(audio.numFrames);
+        ref16[k].resize(audio.numFrames);
+        out[k].resize(audio.numFrames);
+    }
+
+    const ConvertFunction functions[2] = { convertBlockScalar, convertBlockVector };
+    uint64_t bestTimes[2] = { UINT64_MAX, UINT64_MAX };
+
+    for (uint32_t round = 0; round < kConvertRounds; ++round)
+    {
+        for (uint32_t k = 0; k < 2; ++k)
+        {
+            const uint64_t timeStart = getMonotonicTimeNs();
+
+            for (uint32_t b = 0; b < numBlocks; ++b)
+            {
+                const uint32_t pos = b * frameSize;
+                functions[k](mic16[k].data() + pos, ref16[k].data() + pos, out[k].data() + pos,
+                             audio.mic.data() + pos, audio.reference.data() + pos, frameSize);
+            }
+
+            bestTimes[k] = std::min(bestTimes[k], getMonotonicTimeNs() - timeStart);
+        }
+    }
+
+    result.scalarNsPerBlock = numBlocks != 0 ? static_cast<double>(bestTimes[0]) / numBlocks : 0.0;
+    result.vectorNsPerBlock = numBlocks != 0 ? static_cast<double>(bestTimes[1]) / numBlocks : 0.0;
+    result.identical = mic16[0] == mic16[1] && ref16[0] == ref16[1] && out[0] == out[1];
+
+    return result;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static void printResults(const std::vector<Result>& results,
+                         const std::vector<ConvertResult>& convertResults,
+                         const Options& options,
+                         const PluginExporter& plugin)
+{
+    const uint32_t version = plugin.getVersion();
+
+    std::printf("{\n");
+    std::printf("  \"plugin\": \"%s\",\n", plugin.getLabel());
+    std::printf("  \"version\": \"%u.%u.%u\",\n", (version >> 16) & 0xff, (version >> 8) & 0xff, version & 0xff);
+    std::printf("  \"sample_rate\": %.0f,\n", options.sampleRate);
+    std::printf("  \"block_size\": %u,\n", options.blockSize);
+    std::printf("  \"tail_ms\": %.0f,\n", options.tailMs);
+    std::printf("  \"echo_delay_ms\": %.1f,\n", options.echoDelayMs);
+    std::printf("  \"delay_estimation\": %s,\n", options.delayEstimation ? "true" : "false");
+    std::printf("  \"aligned_tail_ms\": %.0f,\n", options.alignedTailMs);
+    std::printf("  \"results\": [\n");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r(results[i]);
+
+        std::printf("    {\n");
+        std::printf("      \"echo_frame_ms\": %u,\n", r.frameSizeMs);
+        std::printf("      \"echo_frame_size\": %u,\n", r.latency);
+        std::printf("      \"echo_calls_per_second\": %.1f,\n", options.sampleRate / r.latency);
+        std::printf("      \"latency\": { \"frames\": %u, \"ms\": %.3f },\n",
+                    r.latency, r.latency * 1000.0 / options.sampleRate);
+        std::printf("      \"rt_factor\": %.3f,\n", r.realtimeFactor);
+        std::printf("      \"ns_per_sample\": %.3f,\n", r.nsPerSample);
+        std::printf("      \"erle_db\": %.2f,\n", r.erleDB);
+        std::printf("      \"estimated_delay_ms\": %.2f,\n", r.estimatedDelayMs);
+        std::printf("      \"effective_tail_ms\": %.0f\n", r.effectiveTailMs);
+        std::printf("    }%s\n", i + 1 != results.size() ? "," : "");
+    }
+
+    std::printf("  ],\n");
+    std::printf("  \"conversion\": [\n");
+
+    for (size_t i = 0; i < convertResults.size(); ++i)
+    {
+        const ConvertResult& r(convertResults[i]);
+
+        std::printf("    {\n");
+        std::printf("      \"echo_frame_size\": %u,\n", r.frameSize);
+        std::printf("      \"scalar_ns_per_block\": %.1f,\n", r.scalarNsPerBlock);
+        std::printf("      \"vector_ns_per_block\": %.1f,\n", r.vectorNsPerBlock);
+        std::printf("      \"saving_ns_per_block\": %.1f,\n", r.scalarNsPerBlock - r.vectorNsPerBlock);
+        std::printf("      \"identical\": %s\n", r.identical ? "true" : "false");
+        std::printf("    }%s\n", i + 1 != convertResults.size() ? "," : "");
+    }
+
+    std::printf("  ]\n");
+    std::printf("}\n");
+}
+
+static void printUsage(const char* const name)
+{
+    std::fprintf(stderr, "Usage: %s [options]\n"
+                         "  --sample-rate <value> host sample rate, defaults to 48000\n"
+                         "  --seconds <value>     length of generated audio, defaults to 10\n"
+                         "  --block-size <value>  host block size, defaults to 480\n"
+                         "  --tail <ms>           echo canceller tail, defaults to 100\n"
+                         "  --echo-delay <ms>     bulk delay of the simulated echo, defaults to 20\n"
+                         "  --delay-estimation    align the reference to its echo, paced in real time\n"
+                         "  --aligned-tail <ms>   echo canceller tail once aligned, defaults to 40\n",
+                 name);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+int main(int argc, char* argv[])
+{
+    USE_NAMESPACE_DISTRHO;
+
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc)
+        {
+            options.sampleRate = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            options.seconds = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--block-size") == 0 && i + 1 < argc)
+        {
+            options.blockSize = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--tail") == 0 && i + 1 < argc)
+        {
+            options.tailMs = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--echo-delay") == 0 && i + 1 < argc)
+        {
+            options.echoDelayMs = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--delay-estimation") == 0)
+        {
+            options.delayEstimation = true;
+        }
+        else if (std::strcmp(argv[i], "--aligned-tail") == 0 && i + 1 < argc)
+        {
+            options.alignedTailMs = static_cast<float>(std::atof(argv[++i]));
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.sampleRate < 8000.0 || options.seconds <= 0.0 || options.blockSize == 0 || options.echoDelayMs < 0.f)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Audio audio;
+    generateAudio(audio, options.sampleRate, options.seconds,
+                  d_roundToUnsignedInt(options.echoDelayMs * 0.001 * options.sampleRate));
+
+    std::vector<Result> results;
+    std::vector<ConvertResult> convertResults;
+
+    for (const uint32_t frameSizeMs : kEchoFrameSizesMs)
+    {
+        std::fprintf(stderr, "Running with echo frame size %ums...\n", frameSizeMs);
+        results.push_back(runBenchmark(audio, frameSizeMs, options));
+
+        // echo frame size in frames is the plugin latency
+        convertResults.push_back(runConvertBenchmark(audio, results.back().latency));
+    }
+
+    // an idle instance for the plugin details
+    d_nextBufferSize = options.blockSize;
+    d_nextSampleRate = options.sampleRate;
+    const PluginExporter plugin(nullptr, nullptr, nullptr, nullptr);
+
+    printResults(results, convertResults, options, plugin);
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// processing time of denoise blocks, relative to the real-time budget of a block
+
+// histogram buckets, each one twice as long as the previous.
+// bucket 9 starts at the full budget, lower ones are fractions of it, the last one is 4x over budget or more
+static constexpr const uint32_t kDspTimingNumBuckets = 12;
+static constexpr const int kDspTimingBudgetBucket = 9;
+
+/**
+   Get current time of a monotonic clock in nanoseconds.
+   This is a vDSO call on Linux and QueryPerformanceCounter on Windows, cheap enough to use a few times per cycle.
+ */
+static inline
+uint64_t getMonotonicTimeNs() noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+   Get the histogram bucket for a processing time of @a load, as a fraction of the budget.
+ */
+static inline
+uint32_t getDspTimingBucket(const double load) noexcept
+{
+    if (load < std::ldexp(1.0, -kDspTimingBudgetBucket))
+        return 0;
+
+    const int bucket = std::ilogb(load) + kDspTimingBudgetBucket;
+    return static_cast<uint32_t>(std::min(bucket, static_cast<int>(kDspTimingNumBuckets - 1)));
+}
+
+class BlockTimingStats
+{
+public:
+    BlockTimingStats() noexcept
+    {
+        reset();
+    }
+
+    void setBudget(const uint64_t ns) noexcept
+    {
+        budgetInv = ns != 0 ? 1.0 / ns : 0.0;
+    }
+
+    void reset() noexcept
+    {
+        current = worst = 0.0;
+        sum = 0.0;
+        count = 0;
+        std::memset(histogram, 0, sizeof(histogram));
+    }
+
+   /**
+      Store the processing time of @a numBlocks blocks, each one having taken @a ns nanoseconds.
+    */
+    void store(const uint64_t ns, const uint32_t numBlocks = 1) noexcept
+    {
+        current = ns * budgetInv;
+        worst = std::max(worst, current);
+        sum += current * numBlocks;
+        count += numBlocks;
+        histogram[getDspTimingBucket(current)] += numBlocks;
+    }
+
+    // loads as percentage of the budget
+    float getCurrentLoad() const noexcept { return static_cast<float>(current * 100.0); }
+    float getAverageLoad() const noexcept { return count != 0 ? static_cast<float>(sum / count * 100.0) : 0.f; }
+    float getWorstLoad() const noexcept { return static_cast<float>(worst * 100.0); }
+
+    const uint32_t* getHistogram() const noexcept
+    {
+        return histogram;
+    }
+
+private:
+    double budgetInv = 0.0;
+    double current, worst, sum;
+    uint64_t count;
+    uint32_t histogram[kDspTimingNumBuckets];
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,113 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define RENOOICE_INT16_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+# include <arm_neon.h>
+# define RENOOICE_INT16_NEON
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// conversion between float audio and the 16-bit samples used by the speex API.
+// speex is built with FLOATING_POINT and converts to float internally, but its API only takes 16-bit samples.
+// vector code saturates and rounds to nearest like the scalar code, so both give the same samples.
+
+static constexpr const float kInt16Scaling = 32767.f;
+
+static constexpr inline
+int16_t float16(const float s)
+{
+    return s <= -1.f ? -32767 :
+           s >= 1.f ? 32767 :
+           std::lrintf(s * kInt16Scaling);
+}
+
+/**
+   Convert @a frames of float audio from @a src into 16-bit samples in @a dst, clipping at full scale.
+ */
+static inline
+void convertFloatToInt16(int16_t* const dst, const float* const src, const uint32_t frames) noexcept
+{
+    uint32_t i = 0;
+
+   #if defined(RENOOICE_INT16_SSE2)
+    const __m128 scale = _mm_set1_ps(kInt16Scaling);
+    const __m128 lo = _mm_set1_ps(-kInt16Scaling);
+    const __m128 hi = _mm_set1_ps(kInt16Scaling);
+
+    for (; i + 8 <= frames; i += 8)
+    {
+        const __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), lo), hi);
+        const __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lo), hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+   #elif defined(RENOOICE_INT16_NEON)
+    const float32x4_t scale = vdupq_n_f32(kInt16Scaling);
+    const float32x4_t lo = vdupq_n_f32(-kInt16Scaling);
+    const float32x4_t hi = vdupq_n_f32(kInt16Scaling);
+
+    for (; i + 8 <= frames; i += 8)
+    {
+        const float32x4_t a = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(src + i), scale), lo), hi);
+        const float32x4_t b = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(src + i + 4), scale), lo), hi);
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b))));
+    }
+   #endif
+
+    for (; i < frames; ++i)
+        dst[i] = float16(src[i]);
+}
+
+/**
+   Convert @a frames of 16-bit samples from @a src into float audio in @a dst.
+   @a scaling can be set to 1 to keep samples in 16-bit units, as used for denoise.
+ */
+static inline
+void convertInt16ToFloat(float* const dst, const int16_t* const src, const uint32_t frames,
+                         const float scaling = 1.f / kInt16Scaling) noexcept
+{
+    uint32_t i = 0;
+
+   #if defined(RENOOICE_INT16_SSE2)
+    const __m128 scale = _mm_set1_ps(scaling);
+
+    for (; i + 8 <= frames; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // sign extension by placing each sample in the upper half and shifting back down
+        const __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+    }
+   #elif defined(RENOOICE_INT16_NEON)
+    const float32x4_t scale = vdupq_n_f32(scaling);
+
+    for (; i + 8 <= frames; i += 8)
+    {
+        const int16x8_t v = vld1q_s16(src + i);
+        vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+   #endif
+
+    for (; i < frames; ++i)
+        dst[i] = static_cast<float>(src[i]) * scaling;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
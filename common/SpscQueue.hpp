@@ -0,0 +1,97 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <atomic>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// wait-free single-producer single-consumer queue with fixed-size slots
+// slots are written and read in place, the queue itself never copies or allocates
+
+template <typename T, uint32_t kCapacity>
+class SpscQueue
+{
+    static_assert(kCapacity != 0 && (kCapacity & (kCapacity - 1)) == 0, "capacity must be a power of 2");
+
+    static constexpr const uint32_t kMask = kCapacity - 1;
+
+    T slots[kCapacity];
+
+    // free-running positions, only ever increment and wrap around naturally
+    // kept on separate cache lines so producer and consumer do not fight over them
+    alignas(64) std::atomic<uint32_t> writePos { 0 };
+    alignas(64) std::atomic<uint32_t> readPos { 0 };
+
+public:
+    SpscQueue() noexcept = default;
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // producer side
+
+   /**
+      Get the next slot for writing, or null if the queue is full.
+      The slot only becomes visible to the consumer after commitWrite().
+    */
+    T* getWriteSlot() noexcept
+    {
+        const uint32_t pos = writePos.load(std::memory_order_relaxed);
+
+        if (pos - readPos.load(std::memory_order_acquire) == kCapacity)
+            return nullptr;
+
+        return &slots[pos & kMask];
+    }
+
+    void commitWrite() noexcept
+    {
+        writePos.store(writePos.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // consumer side
+
+   /**
+      Get the oldest written slot, or null if the queue is empty.
+      The slot stays owned by the consumer until commitRead().
+    */
+    T* getReadSlot() noexcept
+    {
+        const uint32_t pos = readPos.load(std::memory_order_relaxed);
+
+        if (writePos.load(std::memory_order_acquire) == pos)
+            return nullptr;
+
+        return &slots[pos & kMask];
+    }
+
+    void commitRead() noexcept
+    {
+        readPos.store(readPos.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+
+   /**
+      Discard all queued slots.
+      Only safe to call while neither producer nor consumer are active.
+    */
+    void clear() noexcept
+    {
+        writePos.store(0, std::memory_order_relaxed);
+        readPos.store(0, std::memory_order_relaxed);
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(SpscQueue)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
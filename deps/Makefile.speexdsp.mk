@@ -0,0 +1,43 @@
+#!/usr/bin/make -f
+# speexdsp sources and build flags, shared by the plugins, benchmarks and tools
+# SPDX-License-Identifier: ISC
+#
+# include after Makefile.base.mk, then add the wanted FILES_SPEEXDSP_* to the files to build
+# and SPEEXDSP_FLAGS to BASE_FLAGS. flags only speexdsp itself needs are set per object.
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Directory setup, relative to the including makefile
+
+SPEEXDSP_PATH := $(dir $(lastword $(MAKEFILE_LIST)))speexdsp
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Files to build
+
+# sample rate conversion
+FILES_SPEEXDSP_RESAMPLER = \
+	$(SPEEXDSP_PATH)/libspeexdsp/resample.c
+
+# echo canceller and preprocessor
+FILES_SPEEXDSP_ECHO = \
+	$(SPEEXDSP_PATH)/libspeexdsp/fftwrap.c \
+	$(SPEEXDSP_PATH)/libspeexdsp/filterbank.c \
+	$(SPEEXDSP_PATH)/libspeexdsp/kiss_fft.c \
+	$(SPEEXDSP_PATH)/libspeexdsp/kiss_fftr.c \
+	$(SPEEXDSP_PATH)/libspeexdsp/mdf.c \
+	$(SPEEXDSP_PATH)/libspeexdsp/preprocess.c
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Build flags
+
+SPEEXDSP_FLAGS = -I$(SPEEXDSP_PATH)/include
+SPEEXDSP_FLAGS += -I$(SPEEXDSP_PATH)-config
+
+%/speexdsp/libspeexdsp/resample.c.o: BASE_FLAGS += -DEXPORT= -DFLOATING_POINT
+
+ifeq ($(CPU_X86_64),true)
+%/speexdsp/libspeexdsp/resample.c.o: BASE_FLAGS += -DUSE_SSE
+endif
+
+$(patsubst $(SPEEXDSP_PATH)/%,\%/speexdsp/%.o,$(FILES_SPEEXDSP_ECHO)): BASE_FLAGS += -DEXPORT= -DFLOATING_POINT -DUSE_KISS_FFT
+
+# ---------------------------------------------------------------------------------------------------------------------
@@ -6,6 +6,8 @@
 
 #pragma once
 
+// speexdsp normally generates this at configure time, this one is used by all plugins and tools instead
+
 #include <stdint.h>
 
 typedef int16_t spx_int16_t;
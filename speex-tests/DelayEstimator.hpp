@@ -0,0 +1,337 @@
+/*
+ * Re:Speex
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "extra/Thread.hpp"
+
+#include "SpscQueue.hpp"
+
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// estimation of the bulk delay between the far-end reference and its echo in the mic signal.
+// the audio thread only reduces both signals to smoothed amplitude envelopes, 1 value per millisecond (a hop),
+// handing them over in blocks to a background thread that cross-correlates a few seconds of them through an FFT.
+// a delay is only published once the correlation peak is clear and the same on 2 estimates in a row,
+// small changes from the published one are ignored as every change makes the echo canceller start over.
+
+class DelayEstimator : public Thread
+{
+public:
+    // envelope hops per hand-over block, so the background thread wakes up every 100ms
+    static constexpr const uint32_t kBlockHops = 100;
+
+    // reference envelope correlated on each estimate, and the longest delay searched for, in hops
+    static constexpr const uint32_t kWindowHops = 2048;
+    static constexpr const uint32_t kMaxDelayHops = 1000;
+
+    // mic envelope history, covering the reference window at every delay
+    static constexpr const uint32_t kHistoryHops = kWindowHops + kMaxDelayHops;
+
+    // enough for linear correlation over all delays, without circular wrap-around
+    static constexpr const uint32_t kFftSize = 4096;
+    static_assert(kFftSize >= kHistoryHops, "FFT too small for correlation window");
+
+    // normalized correlation peak needed for an estimate to count
+    static constexpr const float kMinCorrelation = 0.5f;
+
+    // estimates this many hops apart are taken as the same delay
+    static constexpr const uint32_t kToleranceHops = 2;
+
+    // reference envelope variance below this is too quiet to correlate against, about -60dBFS
+    static constexpr const float kMinVariance = 1e-6f;
+
+    // time constant of envelope smoothing, long enough that voice pitch does not show up as ripple between hops
+    static constexpr const double kSmoothingMs = 4.0;
+
+    explicit DelayEstimator(const double sampleRate)
+        : Thread("ReSpeex delay estimator"),
+          hopFrames(std::max(1u, d_roundToUnsignedInt(sampleRate * 0.001))),
+          smoothing(static_cast<float>(1.0 - std::exp(-1000.0 / (kSmoothingMs * sampleRate))))
+    {
+        static constexpr const double kPi = 3.14159265358979323846;
+
+        for (uint32_t i = 0; i < kFftSize / 2; ++i)
+            twiddles[i] = std::polar(1.f, static_cast<float>(-2.0 * kPi * i / kFftSize));
+
+        for (uint32_t i = 0, j = 0; i < kFftSize; ++i)
+        {
+            bitReverse[i] = j;
+
+            uint32_t bit = kFftSize >> 1;
+            for (; (j & bit) != 0; bit >>= 1)
+                j ^= bit;
+            j |= bit;
+        }
+    }
+
+   /**
+      Get the duration of an envelope hop, in frames.
+    */
+    uint32_t getHopFrames() const noexcept
+    {
+        return hopFrames;
+    }
+
+   /**
+      Get the latest published delay in frames, negative while none is known yet.
+    */
+    int32_t getDelay() const noexcept
+    {
+        return delay.load(std::memory_order_relaxed);
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        signal.signal();
+        stopThread(-1);
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // audio thread side
+
+   /**
+      Feed @a frames of @a mic and far-end @a reference audio, in sync with each other.
+      Cheap enough for the audio thread, envelopes are handed over to the background thread once a block is full.
+    */
+    void process(const float* const mic, const float* const reference, const uint32_t frames) noexcept
+    {
+        for (uint32_t i = 0; i < frames;)
+        {
+            const uint32_t segment = std::min(frames - i, hopFrames - hopPos);
+
+            for (uint32_t j = i; j < i + segment; ++j)
+            {
+                envelopeMic += (mic[j] * mic[j] - envelopeMic) * smoothing;
+                envelopeReference += (reference[j] * reference[j] - envelopeReference) * smoothing;
+            }
+
+            i += segment;
+
+            if ((hopPos += segment) == hopFrames)
+                finishHop();
+        }
+    }
+
+protected:
+    void run() override
+    {
+        while (! shouldThreadExit())
+        {
+            signal.wait();
+
+            while (const Block* const in = queue.getReadSlot())
+            {
+                // history is kept oldest first, so correlation can run on it in place
+                std::memmove(historyMic, historyMic + kBlockHops, (kHistoryHops - kBlockHops) * sizeof(float));
+                std::memmove(historyReference, historyReference + kBlockHops,
+                             (kHistoryHops - kBlockHops) * sizeof(float));
+                std::memcpy(historyMic + kHistoryHops - kBlockHops, in->mic, sizeof(in->mic));
+                std::memcpy(historyReference + kHistoryHops - kBlockHops, in->reference, sizeof(in->reference));
+
+                historyHops = std::min(historyHops + kBlockHops, static_cast<uint32_t>(kHistoryHops));
+                queue.commitRead();
+            }
+
+            if (historyHops == kHistoryHops)
+                estimate();
+        }
+    }
+
+private:
+    struct Block {
+        float mic[kBlockHops];
+        float reference[kBlockHops];
+    };
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // audio thread side
+
+    const uint32_t hopFrames;
+    const float smoothing;
+
+    // smoothed energy of both signals, taken once per hop, and how far into the current hop we are
+    float envelopeMic = 0.f;
+    float envelopeReference = 0.f;
+    uint32_t hopPos = 0;
+
+    // block being filled, null until the first hop goes into it
+    Block* block = nullptr;
+    uint32_t blockPos = 0;
+
+    void finishHop() noexcept
+    {
+        if (block == nullptr)
+        {
+            // background thread fell behind, this hop is lost for both signals alike
+            if ((block = queue.getWriteSlot()) == nullptr)
+            {
+                hopPos = 0;
+                return;
+            }
+        }
+
+        block->mic[blockPos] = std::sqrt(envelopeMic);
+        block->reference[blockPos] = std::sqrt(envelopeReference);
+
+        hopPos = 0;
+
+        if (++blockPos == kBlockHops)
+        {
+            queue.commitWrite();
+            signal.signal();
+            block = nullptr;
+            blockPos = 0;
+        }
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // shared
+
+    SpscQueue<Block, 64> queue;
+    Signal signal;
+    std::atomic<int32_t> delay { -1 };
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // background thread side
+
+    float historyMic[kHistoryHops] = {};
+    float historyReference[kHistoryHops] = {};
+    uint32_t historyHops = 0;
+
+    // last estimate, published or not, and the last published one
+    int32_t lastLag = -1;
+    int32_t publishedLag = -1;
+
+    std::complex<float> spectrum[kFftSize];
+    std::complex<float> cross[kFftSize];
+    std::complex<float> twiddles[kFftSize / 2];
+    uint32_t bitReverse[kFftSize];
+
+    // prefix sums of squared mic envelope, for normalizing correlation at each delay
+    double micEnergy[kHistoryHops + 1];
+
+   /**
+      Correlate the oldest window of the reference envelope against the whole mic envelope history,
+      at all delays from 0 to kMaxDelayHops, publishing the delay of the peak when it is clear and stable.
+    */
+    void estimate()
+    {
+        float meanReference = 0.f, meanMic = 0.f;
+
+        for (uint32_t i = 0; i < kWindowHops; ++i)
+            meanReference += historyReference[i];
+        for (uint32_t i = 0; i < kHistoryHops; ++i)
+            meanMic += historyMic[i];
+
+        meanReference /= kWindowHops;
+        meanMic /= kHistoryHops;
+
+        // both envelopes in a single complex FFT, reference as real part and mic as imaginary part
+        double referenceEnergy = 0.0;
+        micEnergy[0] = 0.0;
+
+        for (uint32_t i = 0; i < kFftSize; ++i)
+        {
+            const float reference = i < kWindowHops ? historyReference[i] - meanReference : 0.f;
+            const float mic = i < kHistoryHops ? historyMic[i] - meanMic : 0.f;
+
+            spectrum[bitReverse[i]] = std::complex<float>(reference, mic);
+
+            referenceEnergy += reference * reference;
+
+            if (i < kHistoryHops)
+                micEnergy[i + 1] = micEnergy[i] + mic * mic;
+        }
+
+        // far-end is silent or constant, nothing to find
+        if (referenceEnergy < kMinVariance * kWindowHops)
+            return;
+
+        fft();
+
+        // cross spectrum of reference and mic, split out of the combined spectrum using its symmetry.
+        // written bit-reversed for the inverse transform, which is done as a forward one on the conjugate.
+        for (uint32_t k = 0; k < kFftSize; ++k)
+        {
+            const std::complex<float> z = spectrum[k];
+            const std::complex<float> zm = std::conj(spectrum[(kFftSize - k) & (kFftSize - 1)]);
+            const std::complex<float> reference = (z + zm) * 0.5f;
+            const std::complex<float> mic = (z - zm) * std::complex<float>(0.f, -0.5f);
+
+            cross[bitReverse[k]] = std::conj(std::conj(reference) * mic);
+        }
+
+        std::memcpy(spectrum, cross, sizeof(cross));
+        fft();
+
+        int32_t lag = -1;
+        float peak = 0.f;
+
+        for (uint32_t l = 0; l <= kMaxDelayHops; ++l)
+        {
+            const double energy = referenceEnergy * (micEnergy[l + kWindowHops] - micEnergy[l]);
+
+            if (energy <= 0.0)
+                continue;
+
+            const float correlation = static_cast<float>(spectrum[l].real() / kFftSize / std::sqrt(energy));
+
+            if (correlation > peak)
+            {
+                peak = correlation;
+                lag = static_cast<int32_t>(l);
+            }
+        }
+
+        if (peak < kMinCorrelation)
+            return;
+
+        if (lastLag >= 0 && static_cast<uint32_t>(std::abs(lag - lastLag)) <= kToleranceHops
+            && (publishedLag < 0 || static_cast<uint32_t>(std::abs(lag - publishedLag)) > kToleranceHops))
+        {
+            publishedLag = lag;
+            delay.store(lag * static_cast<int32_t>(hopFrames), std::memory_order_relaxed);
+        }
+
+        lastLag = lag;
+    }
+
+   /**
+      In-place radix-2 FFT of spectrum, which must already be in bit-reversed order.
+    */
+    void fft() noexcept
+    {
+        for (uint32_t size = 2; size <= kFftSize; size <<= 1)
+        {
+            const uint32_t half = size >> 1;
+            const uint32_t stride = kFftSize / size;
+
+            for (uint32_t start = 0; start < kFftSize; start += size)
+            {
+                for (uint32_t i = 0; i < half; ++i)
+                {
+                    const std::complex<float> t = twiddles[i * stride] * spectrum[start + i + half];
+                    spectrum[start + i + half] = spectrum[start + i] - t;
+                    spectrum[start + i] += t;
+                }
+            }
+        }
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(DelayEstimator)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
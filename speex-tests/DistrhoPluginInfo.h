@@ -9,9 +9,21 @@
    Stored in a common header file for convenience
  */
 enum Parameters {
+    kParamEchoFrameSize,
+    kParamEchoTail,
+    kParamDelayEstimation,
+    kParamAlignedTail,
+    kParamEstimatedDelay,
+    kParamEffectiveTail,
     kParamCount,
 };
 
+/**
+   Echo canceller block sizes to choose from, in milliseconds, converted to frames at the host sample rate.
+   Smaller blocks mean less latency but more calls into speex for the same audio.
+ */
+static constexpr const uint32_t kEchoFrameSizesMs[] = { 1, 2, 4, 5, 10, 20 };
+
 /**
    The plugin name.
    This is used to identify your plugin before a Plugin instance can be created.
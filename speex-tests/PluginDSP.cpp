@@ -8,6 +8,9 @@
 #include "extra/RingBuffer.hpp"
 #include "extra/ValueSmoother.hpp"
 
+#include "Int16Convert.hpp"
+#include "DelayEstimator.hpp"
+
 #include "speex/speex_echo.h"
 #include "speex/speex_preprocess.h"
 
@@ -15,14 +18,6 @@ START_NAMESPACE_DISTRHO
 
 // --------------------------------------------------------------------------------------------------------------------
 
-static constexpr inline
-int16_t float16(const float s)
-{
-    return s <= -1.f ? -32767 :
-           s >= 1.f ? 32767 :
-           std::lrintf(s * 32767.f);
-}
-
 // FIXME
 static constexpr inline
 uint32_t rnnoise_get_frame_size()
@@ -41,13 +36,36 @@ class ReSpeexPlugin : public Plugin
     // denoise block size
     const uint32_t denoiseFrameSize = static_cast<uint32_t>(rnnoise_get_frame_size());
 
-    // echo canceller block size
-    static constexpr const uint32_t echoFrameSize = 32;
-    const uint32_t echoFilterLength = denoiseFrameSize * 10;
+    // echo canceller block size and filter length, in frames, only changed on activation
+    uint32_t echoFrameSize = 0;
+    uint32_t echoFilterLength = 0;
+
+    // echo canceller handles, created on activation.
+    // with delay estimation a second echo canceller with a shorter tail takes over once the reference is aligned,
+    // echoActive being the one in use.
+    SpeexEchoState* echo = nullptr;
+    SpeexEchoState* echoAligned = nullptr;
+    SpeexEchoState* echoActive = nullptr;
+    SpeexPreprocessState* preproc = nullptr;
+
+    // reference is delayed this much less than the estimate, in case the echo starts a bit early
+    static constexpr const double kDelayMarginMs = 10.0;
+
+    // delay estimation running in the background, null when disabled
+    DelayEstimator* delayEstimator = nullptr;
 
-    // echo canceller handle, keep it const so we never modify it
-    SpeexEchoState* const echo = speex_echo_state_init(echoFrameSize, echoFilterLength);
-    SpeexPreprocessState* const preproc = speex_preprocess_state_init(echoFrameSize, 48000);
+    // far-end reference delay line, only used with delay estimation, a power of 2 in size
+    spx_int16_t* delayLine = nullptr;
+    uint32_t delayLineMask = 0;
+    uint32_t delayLinePos = 0;
+
+    // estimate currently applied (negative while unknown) and the resulting reference delay, in frames
+    int32_t alignDelay = -1;
+    uint32_t alignFrames = 0;
+    uint32_t delayMarginFrames = 0;
+
+    // cached parameter values
+    float parameters[kParamCount] = {};
 
     // buffers for latent processing
     spx_int16_t* bufferInDry;
@@ -70,24 +88,13 @@ public:
     ReSpeexPlugin()
         : Plugin(kParamCount, 0, 0) // parameters, programs, states
     {
-        int sampleRate = 48000;
-        speex_echo_ctl(echo, SPEEX_ECHO_SET_SAMPLING_RATE, &sampleRate);
-        speex_preprocess_ctl(preproc, SPEEX_PREPROCESS_SET_ECHO_STATE, echo);
+        parameters[kParamEchoFrameSize] = kEchoFrameSizesMs[0];
+        parameters[kParamEchoTail] = 100.f;
+        parameters[kParamAlignedTail] = 40.f;
+        parameters[kParamEffectiveTail] = 100.f;
 
-        spx_int32_t off = 0;
-        speex_preprocess_ctl(preproc, SPEEX_PREPROCESS_SET_DENOISE, &off);
-
-        // initial sample rate setup
-        sampleRateChanged(getSampleRate());
-    }
-
-   /**
-      Destructor.
-    */
-    ~ReSpeexPlugin()
-    {
-        speex_echo_state_destroy(echo);
-        speex_preprocess_state_destroy(preproc);
+        // latency is the echo canceller block size, reported ahead of activation
+        setLatency(getEchoFrameSize());
     }
 
 protected:
@@ -128,6 +135,110 @@ protected:
         return d_version(1, 0, 0);
     }
 
+    // ----------------------------------------------------------------------------------------------------------------
+    // Init
+
+   /**
+      Initialize the parameter @a index.
+      This function will be called once, shortly after the plugin is created.
+    */
+    void initParameter(uint32_t index, Parameter& parameter) override
+    {
+        parameter.hints = kParameterIsAutomatable;
+
+        switch (index)
+        {
+        case kParamEchoFrameSize:
+            // echo canceller is created on activation, so this cannot be automated
+            parameter.hints = kParameterIsInteger;
+            parameter.name   = "Echo Frame Size";
+            parameter.symbol = "echo_frame_size";
+            parameter.unit   = "ms";
+            parameter.ranges.def = kEchoFrameSizesMs[0];
+            parameter.ranges.min = kEchoFrameSizesMs[0];
+            parameter.ranges.max = kEchoFrameSizesMs[ARRAY_SIZE(kEchoFrameSizesMs) - 1];
+            parameter.enumValues.count = ARRAY_SIZE(kEchoFrameSizesMs);
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[ARRAY_SIZE(kEchoFrameSizesMs)];
+                for (uint32_t i = 0; i < ARRAY_SIZE(kEchoFrameSizesMs); ++i)
+                {
+                    values[i].label = String(kEchoFrameSizesMs[i]);
+                    values[i].value = kEchoFrameSizesMs[i];
+                }
+                parameter.enumValues.values = values;
+            }
+            break;
+        case kParamEchoTail:
+            // same for the rest of the echo canceller setup
+            parameter.hints = kParameterIsInteger;
+            parameter.name   = "Echo Tail";
+            parameter.symbol = "echo_tail";
+            parameter.unit   = "ms";
+            parameter.ranges.def = 100.f;
+            parameter.ranges.min = 10.f;
+            parameter.ranges.max = 500.f;
+            break;
+        case kParamDelayEstimation:
+            parameter.hints = kParameterIsBoolean | kParameterIsInteger;
+            parameter.name   = "Delay Estimation";
+            parameter.symbol = "delay_estimation";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 1.f;
+            break;
+        case kParamAlignedTail:
+            parameter.hints = kParameterIsInteger;
+            parameter.name   = "Aligned Echo Tail";
+            parameter.symbol = "aligned_tail";
+            parameter.unit   = "ms";
+            parameter.ranges.def = 40.f;
+            parameter.ranges.min = 10.f;
+            parameter.ranges.max = 500.f;
+            break;
+        case kParamEstimatedDelay:
+            parameter.hints |= kParameterIsOutput;
+            parameter.name   = "Estimated Delay";
+            parameter.symbol = "estimated_delay";
+            parameter.unit   = "ms";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 1000.f;
+            break;
+        case kParamEffectiveTail:
+            parameter.hints |= kParameterIsOutput | kParameterIsInteger;
+            parameter.name   = "Effective Echo Tail";
+            parameter.symbol = "effective_tail";
+            parameter.unit   = "ms";
+            parameter.ranges.def = 100.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 500.f;
+            break;
+        }
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // Internal data
+
+   /**
+      Get the current value of a parameter.
+      The host may call this function from any context, including realtime processing.
+    */
+    float getParameterValue(uint32_t index) const override
+    {
+        return parameters[index];
+    }
+
+   /**
+      Change a parameter value.
+      The host may call this function from any context, including realtime processing.
+      Echo canceller settings only apply on the next activation.
+    */
+    void setParameterValue(uint32_t index, float value) override
+    {
+        parameters[index] = value;
+    }
+
     // ----------------------------------------------------------------------------------------------------------------
     // Audio/MIDI Processing
 
@@ -136,8 +247,50 @@ protected:
     */
     void activate() override
     {
+        // echo canceller is recreated for the current settings and sample rate, block size being the only latency.
+        // speex runs at the host rate, so lower rates mean less work for the same duration.
+        const double sampleRate = getSampleRate();
+        int speexSampleRate = static_cast<int>(d_roundToUnsignedInt(sampleRate));
+
+        echoFrameSize = getEchoFrameSize();
+        echoFilterLength = d_roundToUnsignedInt(parameters[kParamEchoTail] * 0.001 * sampleRate);
+        setLatency(echoFrameSize);
+
+        echo = speex_echo_state_init(echoFrameSize, echoFilterLength);
+        preproc = speex_preprocess_state_init(echoFrameSize, speexSampleRate);
+
+        speex_echo_ctl(echo, SPEEX_ECHO_SET_SAMPLING_RATE, &speexSampleRate);
+        speex_preprocess_ctl(preproc, SPEEX_PREPROCESS_SET_ECHO_STATE, echo);
+
+        spx_int32_t off = 0;
+        speex_preprocess_ctl(preproc, SPEEX_PREPROCESS_SET_DENOISE, &off);
+
+        echoActive = echo;
+        parameters[kParamEstimatedDelay] = 0.f;
+        parameters[kParamEffectiveTail] = parameters[kParamEchoTail];
+
+        // with a known bulk delay the filter only needs to cover the room response, the full tail is used until then
+        if (parameters[kParamDelayEstimation] > 0.5f)
+        {
+            echoAligned = speex_echo_state_init(echoFrameSize,
+                                                d_roundToUnsignedInt(parameters[kParamAlignedTail] * 0.001 * sampleRate));
+            speex_echo_ctl(echoAligned, SPEEX_ECHO_SET_SAMPLING_RATE, &speexSampleRate);
+
+            delayEstimator = new DelayEstimator(sampleRate);
+            delayEstimator->startThread();
+
+            const uint32_t maxDelay = DelayEstimator::kMaxDelayHops * delayEstimator->getHopFrames();
+            delayLineMask = d_nextPowerOf2(maxDelay + echoFrameSize) - 1;
+            delayLine = new spx_int16_t[delayLineMask + 1]();
+            delayLinePos = 0;
+            delayMarginFrames = d_roundToUnsignedInt(kDelayMarginMs * 0.001 * sampleRate);
+            alignDelay = -1;
+            alignFrames = 0;
+        }
+
         // ringBufferDry.createBuffer((denoiseFrameSize + echoFrameSize) * sizeof(int16_t) * 2);
-        ringBufferOut.createBuffer(denoiseFrameSize * sizeof(float) * 2);
+        // output waiting to be read is 2 blocks at most, when a new block completes before the previous is fully read
+        ringBufferOut.createBuffer((echoFrameSize * 2 + 1) * sizeof(float));
 
         bufferInDry = new spx_int16_t[echoFrameSize];
         bufferInWet = new spx_int16_t[echoFrameSize];
@@ -153,6 +306,16 @@ protected:
     */
     void deactivate() override
     {
+        if (delayEstimator != nullptr)
+        {
+            delayEstimator->stop();
+            delete delayEstimator;
+            delayEstimator = nullptr;
+        }
+
+        delete[] delayLine;
+        delayLine = nullptr;
+
         delete[] bufferInDry;
         delete[] bufferInWet;
         delete[] bufferOut;
@@ -160,6 +323,18 @@ protected:
 
         // ringBufferDry.deleteBuffer();
         ringBufferOut.deleteBuffer();
+
+        speex_preprocess_state_destroy(preproc);
+        speex_echo_state_destroy(echo);
+        preproc = nullptr;
+        echo = nullptr;
+        echoActive = nullptr;
+
+        if (echoAligned != nullptr)
+        {
+            speex_echo_state_destroy(echoAligned);
+            echoAligned = nullptr;
+        }
     }
 
    /**
@@ -174,6 +349,15 @@ protected:
 
         uint32_t offset = 0;
 
+        // pick up the latest delay estimate
+        if (delayEstimator != nullptr)
+        {
+            const int32_t delay = delayEstimator->getDelay();
+
+            if (delay >= 0 && delay != alignDelay)
+                alignReference(delay);
+        }
+
 #if 0
         // capture enough frames in dry buffer (compensating Re:Nooice latency)
         if (! latent)
@@ -199,11 +383,18 @@ protected:
             const uint32_t framesCycle = std::min(echoFrameSize - bufferInPos, frames - offset);
 
             // copy input data into buffers
-            for (uint32_t i = 0; i < framesCycle; ++i)
+            // ringBufferDry.writeShort(float16(inDry[i]));
+            convertFloatToInt16(bufferInDry + bufferInPos, inDry, framesCycle);
+
+            // with delay estimation the reference goes through the delay line, taken out once the block is full
+            if (delayEstimator != nullptr)
             {
-                // ringBufferDry.writeShort(float16(inDry[i]));
-                bufferInDry[bufferInPos + i] = float16(inDry[i]);
-                bufferInWet[bufferInPos + i] = float16(inWet[i]);
+                delayEstimator->process(inDry, inWet, framesCycle);
+                writeDelayLine(inWet, framesCycle);
+            }
+            else
+            {
+                convertFloatToInt16(bufferInWet + bufferInPos, inWet, framesCycle);
             }
 
             // ringBufferDry.commitWrite();
@@ -215,13 +406,15 @@ protected:
 
                 // ringBufferDry.readCustomData(bufferInDry, framesCycle * sizeof(int16_t));
 
+                if (delayEstimator != nullptr)
+                    readDelayLine(bufferInWet);
+
                 // run denoise
-                speex_echo_cancellation(echo, bufferInDry, bufferInWet, bufferOut);
+                speex_echo_cancellation(echoActive, bufferInDry, bufferInWet, bufferOut);
                 speex_preprocess_run(preproc, bufferOut);
 
                 // scale back down to regular audio level
-                for (uint32_t i = 0; i < echoFrameSize; ++i)
-                    bufferOutFloat[i] = static_cast<float>(bufferOut[i]) * (1.f / 32767.f);
+                convertInt16ToFloat(bufferOutFloat, bufferOut, echoFrameSize);
 
                 // write denoise output into ringbuffer
                 ringBufferOut.writeCustomData(bufferOutFloat, echoFrameSize * sizeof(float));
@@ -255,9 +448,80 @@ protected:
       Optional callback to inform the plugin about a sample rate change.
       This function will only be called when the plugin is deactivated.
     */
-    void sampleRateChanged(const double sampleRate) override
+    void sampleRateChanged(double) override
+    {
+        // echo frame size is in milliseconds, so latency in frames follows the rate.
+        // speex states are recreated for the new rate on the next activation.
+        setLatency(getEchoFrameSize());
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+
+   /**
+      Delay the reference by the estimated @a delay in frames, minus some margin, and switch to the aligned filter.
+      The aligned filter starts over each time, as its previous state was adapted to another delay.
+    */
+    void alignReference(const int32_t delay) noexcept
+    {
+        alignDelay = delay;
+        alignFrames = static_cast<uint32_t>(delay) > delayMarginFrames ? delay - delayMarginFrames : 0;
+
+        speex_echo_state_reset(echoAligned);
+
+        if (echoActive != echoAligned)
+        {
+            echoActive = echoAligned;
+            speex_preprocess_ctl(preproc, SPEEX_PREPROCESS_SET_ECHO_STATE, echoAligned);
+        }
+
+        parameters[kParamEstimatedDelay] = static_cast<float>(delay * 1000.0 / getSampleRate());
+        parameters[kParamEffectiveTail] = parameters[kParamAlignedTail];
+    }
+
+   /**
+      Write @a frames of far-end @a reference audio into the delay line, as 16-bit samples.
+    */
+    void writeDelayLine(const float* const reference, const uint32_t frames) noexcept
+    {
+        const uint32_t first = std::min(frames, delayLineMask + 1 - delayLinePos);
+
+        convertFloatToInt16(delayLine + delayLinePos, reference, first);
+        convertFloatToInt16(delayLine, reference + first, frames - first);
+
+        delayLinePos = (delayLinePos + frames) & delayLineMask;
+    }
+
+   /**
+      Read the reference for the echo block that just completed out of the delay line, delayed by alignFrames.
+    */
+    void readDelayLine(spx_int16_t* const reference) const noexcept
+    {
+        const uint32_t start = (delayLinePos - echoFrameSize - alignFrames) & delayLineMask;
+        const uint32_t first = std::min(echoFrameSize, delayLineMask + 1 - start);
+
+        std::memcpy(reference, delayLine + start, first * sizeof(spx_int16_t));
+        std::memcpy(reference + first, delayLine, (echoFrameSize - first) * sizeof(spx_int16_t));
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+
+   /**
+      Get the echo canceller block size in frames at the current sample rate,
+      from its parameter in milliseconds snapped to the closest allowed one.
+      Rounded to an even number of frames, as speex runs its FFT on twice the block size.
+    */
+    uint32_t getEchoFrameSize() const noexcept
     {
-        setLatency(d_roundToUnsignedInt(sampleRate / 48000.0 * (denoiseFrameSize + echoFrameSize)));
+        const float value = parameters[kParamEchoFrameSize];
+        uint32_t frameSizeMs = kEchoFrameSizesMs[0];
+
+        for (const uint32_t size : kEchoFrameSizesMs)
+        {
+            if (std::abs(value - size) < std::abs(value - frameSizeMs))
+                frameSizeMs = size;
+        }
+
+        return std::max(2u, d_roundToUnsignedInt(frameSizeMs * getSampleRate() / 2000) * 2);
     }
 
     // ----------------------------------------------------------------------------------------------------------------
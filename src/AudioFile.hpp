@@ -0,0 +1,687 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef HAVE_FLAC
+# include <FLAC/stream_decoder.h>
+# include <FLAC/stream_encoder.h>
+#endif
+
+#ifdef DISTRHO_OS_WINDOWS
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// audio file reading and writing for offline tools, converting to and from planar float
+// WAV files are memory-mapped for reading and written through a large buffer, switching to RF64 when over 4GiB.
+// FLAC goes through libFLAC, only available when built with HAVE_FLAC.
+
+struct AudioFileInfo {
+    uint32_t numChannels = 0;
+    uint32_t sampleRate = 0;
+    uint32_t bitsPerSample = 0;
+    bool isFloat = false;
+    bool isFlac = false;
+    uint64_t numFrames = 0;
+};
+
+static inline
+uint64_t readAudioFileLE(const uint8_t* const data, const uint32_t size) noexcept
+{
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < size; ++i)
+        value |= static_cast<uint64_t>(data[i]) << (i * 8);
+    return value;
+}
+
+static inline
+void writeAudioFileLE(uint8_t* const data, uint64_t value, const uint32_t size) noexcept
+{
+    for (uint32_t i = 0; i < size; ++i, value >>= 8)
+        data[i] = static_cast<uint8_t>(value & 0xff);
+}
+
+/**
+   Convert a float sample to an integer of @a bits, rounding and clipping to the valid range.
+ */
+static inline
+int32_t floatToAudioFileInt(const float sample, const uint32_t bits) noexcept
+{
+    const double scale = static_cast<double>(1u << (bits - 1));
+    const double value = std::nearbyint(static_cast<double>(sample) * scale);
+    return static_cast<int32_t>(std::max(-scale, std::min(scale - 1.0, value)));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+class AudioFileReader
+{
+public:
+    AudioFileReader() noexcept {}
+
+    ~AudioFileReader()
+    {
+        close();
+    }
+
+   /**
+      Open a WAV, RF64 or FLAC file for reading, with the format detected from its contents.
+    */
+    bool open(const char* const filename)
+    {
+        close();
+
+        char magic[4] = {};
+        if (FILE* const file = std::fopen(filename, "rb"))
+        {
+            const size_t r = std::fread(magic, 1, sizeof(magic), file);
+            std::fclose(file);
+            DISTRHO_SAFE_ASSERT_RETURN(r == sizeof(magic), false);
+        }
+        else
+        {
+            d_stderr2("Failed to open audio file '%s'", filename);
+            return false;
+        }
+
+        if (std::memcmp(magic, "fLaC", 4) == 0)
+        {
+           #ifdef HAVE_FLAC
+            return openFlac(filename);
+           #else
+            d_stderr2("Cannot read '%s', built without FLAC support", filename);
+            return false;
+           #endif
+        }
+
+        return openWav(filename);
+    }
+
+    void close() noexcept
+    {
+       #ifdef HAVE_FLAC
+        if (decoder != nullptr)
+        {
+            FLAC__stream_decoder_delete(decoder);
+            decoder = nullptr;
+        }
+        decoded.clear();
+        decodedFrames = decodedPos = 0;
+       #endif
+
+        if (mapData != nullptr)
+        {
+           #ifdef DISTRHO_OS_WINDOWS
+            UnmapViewOfFile(mapData);
+            CloseHandle(mapping);
+            mapping = nullptr;
+           #else
+            munmap(const_cast<uint8_t*>(mapData), mapSize);
+           #endif
+            mapData = nullptr;
+            mapSize = 0;
+        }
+
+        samples = nullptr;
+        position = 0;
+        info = AudioFileInfo();
+    }
+
+    const AudioFileInfo& getInfo() const noexcept
+    {
+        return info;
+    }
+
+   /**
+      Move the reading position to @a frame, which can be anywhere within the file.
+    */
+    bool seek(const uint64_t frame)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(frame <= info.numFrames, false);
+
+       #ifdef HAVE_FLAC
+        if (decoder != nullptr)
+        {
+            // the decoder calls back with the frame containing the target sample, starting from it
+            decodedFrames = decodedPos = 0;
+
+            if (frame != info.numFrames && ! FLAC__stream_decoder_seek_absolute(decoder, frame))
+                return false;
+        }
+       #endif
+
+        position = frame;
+        return true;
+    }
+
+   /**
+      Read up to @a frames frames into @a buffers, one per channel of the file.
+      Returns the number of frames read, which is less than requested only at the end of the file.
+    */
+    uint32_t read(float* const* const buffers, uint32_t frames)
+    {
+        frames = static_cast<uint32_t>(std::min<uint64_t>(frames, info.numFrames - position));
+
+       #ifdef HAVE_FLAC
+        if (decoder != nullptr)
+            return readFlac(buffers, frames);
+       #endif
+
+        DISTRHO_SAFE_ASSERT_RETURN(samples != nullptr, 0);
+
+        const uint32_t numChannels = info.numChannels;
+        const uint32_t bytesPerSample = info.bitsPerSample / 8;
+        const uint8_t* src = samples + position * numChannels * bytesPerSample;
+
+        if (info.isFloat)
+        {
+            for (uint32_t i = 0; i < frames; ++i)
+                for (uint32_t c = 0; c < numChannels; ++c, src += sizeof(float))
+                    std::memcpy(&buffers[c][i], src, sizeof(float));
+        }
+        else
+        {
+            // move to the top bits so sign is kept, then scale by the full 32-bit range
+            const uint32_t shift = 32 - info.bitsPerSample;
+
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                for (uint32_t c = 0; c < numChannels; ++c, src += bytesPerSample)
+                {
+                    const uint32_t value = static_cast<uint32_t>(readAudioFileLE(src, bytesPerSample)) << shift;
+                    buffers[c][i] = static_cast<float>(static_cast<int32_t>(value) / 2147483648.0);
+                }
+            }
+        }
+
+        position += frames;
+        return frames;
+    }
+
+private:
+    AudioFileInfo info;
+    uint64_t position = 0;
+
+    // memory-mapped WAV file
+    const uint8_t* mapData = nullptr;
+    size_t mapSize = 0;
+    const uint8_t* samples = nullptr;
+   #ifdef DISTRHO_OS_WINDOWS
+    HANDLE mapping = nullptr;
+   #endif
+
+    bool openWav(const char* const filename)
+    {
+       #ifdef DISTRHO_OS_WINDOWS
+        const HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        DISTRHO_SAFE_ASSERT_RETURN(file != INVALID_HANDLE_VALUE, false);
+
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 12)
+        {
+            if ((mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) != nullptr)
+            {
+                mapData = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                mapSize = static_cast<size_t>(fileSize.QuadPart);
+
+                if (mapData == nullptr)
+                {
+                    CloseHandle(mapping);
+                    mapping = nullptr;
+                }
+            }
+        }
+
+        CloseHandle(file);
+       #else
+        const int fd = ::open(filename, O_RDONLY);
+        DISTRHO_SAFE_ASSERT_RETURN(fd >= 0, false);
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 12)
+        {
+            void* const data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+            if (data != MAP_FAILED)
+            {
+                // audio is read once from start to end, let the kernel read ahead aggressively
+                madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                mapData = static_cast<const uint8_t*>(data);
+                mapSize = static_cast<size_t>(st.st_size);
+            }
+        }
+
+        ::close(fd);
+       #endif
+
+        if (mapData == nullptr)
+        {
+            d_stderr2("Failed to map audio file '%s'", filename);
+            return false;
+        }
+
+        if (! parseWav())
+        {
+            d_stderr2("Unsupported audio file '%s', only 16, 24 and 32-bit WAV and RF64 files are supported",
+                      filename);
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool parseWav() noexcept
+    {
+        const bool isRF64 = std::memcmp(mapData, "RF64", 4) == 0;
+        DISTRHO_SAFE_ASSERT_RETURN(isRF64 || std::memcmp(mapData, "RIFF", 4) == 0, false);
+        DISTRHO_SAFE_ASSERT_RETURN(std::memcmp(mapData + 8, "WAVE", 4) == 0, false);
+
+        uint32_t format = 0;
+        uint64_t dataSize = 0, rf64DataSize = 0;
+
+        for (size_t pos = 12; pos + 8 <= mapSize;)
+        {
+            const uint8_t* const header = mapData + pos;
+            uint64_t size = readAudioFileLE(header + 4, 4);
+
+            if (std::memcmp(header, "ds64", 4) == 0 && size >= 24)
+            {
+                rf64DataSize = readAudioFileLE(header + 16, 8);
+            }
+            else if (std::memcmp(header, "fmt ", 4) == 0 && size >= 16)
+            {
+                format = static_cast<uint32_t>(readAudioFileLE(header + 8, 2));
+                info.numChannels = static_cast<uint32_t>(readAudioFileLE(header + 10, 2));
+                info.sampleRate = static_cast<uint32_t>(readAudioFileLE(header + 12, 4));
+                info.bitsPerSample = static_cast<uint32_t>(readAudioFileLE(header + 22, 2));
+
+                // WAVE_FORMAT_EXTENSIBLE, actual format is at the start of the sub-format GUID
+                if (format == 0xfffe && size >= 26)
+                    format = static_cast<uint32_t>(readAudioFileLE(header + 32, 2));
+            }
+            else if (std::memcmp(header, "data", 4) == 0)
+            {
+                if (isRF64 && size == 0xffffffff)
+                    size = rf64DataSize;
+
+                samples = header + 8;
+                dataSize = std::min<uint64_t>(size, mapSize - pos - 8);
+                break;
+            }
+
+            pos += 8 + size + (size & 1);
+        }
+
+        DISTRHO_SAFE_ASSERT_RETURN(samples != nullptr && info.numChannels != 0 && info.sampleRate != 0, false);
+
+        info.isFloat = format == 3;
+        DISTRHO_SAFE_ASSERT_RETURN((format == 1 && (info.bitsPerSample == 16 || info.bitsPerSample == 24
+                                                    || info.bitsPerSample == 32))
+                                   || (info.isFloat && info.bitsPerSample == 32), false);
+
+        info.numFrames = dataSize / (info.bitsPerSample / 8 * info.numChannels);
+        return true;
+    }
+
+   #ifdef HAVE_FLAC
+    FLAC__StreamDecoder* decoder = nullptr;
+
+    // planar samples of the last decoded FLAC frame
+    std::vector<int32_t> decoded;
+    uint32_t decodedFrames = 0;
+    uint32_t decodedPos = 0;
+
+    bool openFlac(const char* const filename)
+    {
+        decoder = FLAC__stream_decoder_new();
+        DISTRHO_SAFE_ASSERT_RETURN(decoder != nullptr, false);
+
+        info.isFlac = true;
+
+        if (FLAC__stream_decoder_init_file(decoder, filename, flacWriteCallback, flacMetadataCallback,
+                                           flacErrorCallback, this) != FLAC__STREAM_DECODER_INIT_STATUS_OK
+            || ! FLAC__stream_decoder_process_until_end_of_metadata(decoder)
+            || info.sampleRate == 0 || info.numFrames == 0)
+        {
+            d_stderr2("Failed to open FLAC file '%s', or its length is unknown", filename);
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    uint32_t readFlac(float* const* const buffers, const uint32_t frames)
+    {
+        const uint32_t numChannels = info.numChannels;
+        const float scale = 1.f / static_cast<float>(1u << (info.bitsPerSample - 1));
+        uint32_t done = 0;
+
+        while (done < frames)
+        {
+            if (decodedPos == decodedFrames)
+            {
+                decodedFrames = decodedPos = 0;
+
+                if (! FLAC__stream_decoder_process_single(decoder) || decodedFrames == 0)
+                    break;
+            }
+
+            const uint32_t n = std::min(frames - done, decodedFrames - decodedPos);
+
+            for (uint32_t c = 0; c < numChannels; ++c)
+            {
+                const int32_t* const src = decoded.data() + c * decodedFrames + decodedPos;
+
+                for (uint32_t i = 0; i < n; ++i)
+                    buffers[c][done + i] = static_cast<float>(src[i]) * scale;
+            }
+
+            decodedPos += n;
+            done += n;
+        }
+
+        position += done;
+        return done;
+    }
+
+    static FLAC__StreamDecoderWriteStatus flacWriteCallback(const FLAC__StreamDecoder*,
+                                                            const FLAC__Frame* const frame,
+                                                            const FLAC__int32* const buffer[],
+                                                            void* const clientData)
+    {
+        AudioFileReader* const self = static_cast<AudioFileReader*>(clientData);
+        const uint32_t numFrames = frame->header.blocksize;
+
+        self->decoded.resize(static_cast<size_t>(numFrames) * self->info.numChannels);
+
+        for (uint32_t c = 0; c < self->info.numChannels; ++c)
+            std::memcpy(self->decoded.data() + c * numFrames, buffer[c], sizeof(int32_t) * numFrames);
+
+        self->decodedFrames = numFrames;
+        self->decodedPos = 0;
+        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+    }
+
+    static void flacMetadataCallback(const FLAC__StreamDecoder*,
+                                     const FLAC__StreamMetadata* const metadata,
+                                     void* const clientData)
+    {
+        if (metadata->type != FLAC__METADATA_TYPE_STREAMINFO)
+            return;
+
+        AudioFileInfo& info(static_cast<AudioFileReader*>(clientData)->info);
+        info.numChannels = metadata->data.stream_info.channels;
+        info.sampleRate = metadata->data.stream_info.sample_rate;
+        info.bitsPerSample = metadata->data.stream_info.bits_per_sample;
+        info.numFrames = metadata->data.stream_info.total_samples;
+    }
+
+    static void flacErrorCallback(const FLAC__StreamDecoder*, const FLAC__StreamDecoderErrorStatus status, void*)
+    {
+        d_stderr2("FLAC decoding error: %s", FLAC__StreamDecoderErrorStatusString[status]);
+    }
+   #endif
+
+    DISTRHO_DECLARE_NON_COPYABLE(AudioFileReader)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+class AudioFileWriter
+{
+    // size of the stdio buffer, so disk writes happen in large blocks
+    static constexpr const size_t kWriteBufferSize = 1024 * 1024;
+
+    // RIFF header, JUNK chunk reserved for a ds64 one, fmt chunk and data chunk header
+    static constexpr const uint32_t kWavHeaderSize = 12 + 8 + 28 + 8 + 16 + 8;
+
+public:
+    AudioFileWriter() noexcept {}
+
+    ~AudioFileWriter()
+    {
+        close();
+    }
+
+   /**
+      Open @a filename for writing audio as described by @a fileInfo, as FLAC if fileInfo.isFlac is set.
+      FLAC output uses the frame count of @a fileInfo as estimate, the real one is written on close.
+    */
+    bool open(const char* const filename, const AudioFileInfo& fileInfo)
+    {
+        close();
+
+        info = fileInfo;
+        numFramesWritten = 0;
+        failed = false;
+
+        if (info.isFlac)
+        {
+           #ifdef HAVE_FLAC
+            DISTRHO_SAFE_ASSERT_RETURN(! info.isFloat && info.bitsPerSample <= 24, false);
+            return openFlac(filename);
+           #else
+            d_stderr2("Cannot write '%s', built without FLAC support", filename);
+            return false;
+           #endif
+        }
+
+        DISTRHO_SAFE_ASSERT_RETURN(info.bitsPerSample == 16 || info.bitsPerSample == 24
+                                   || info.bitsPerSample == 32, false);
+
+        file = std::fopen(filename, "wb");
+
+        if (file == nullptr)
+        {
+            d_stderr2("Failed to create audio file '%s'", filename);
+            return false;
+        }
+
+        std::setvbuf(file, nullptr, _IOFBF, kWriteBufferSize);
+
+        // sizes are filled in on close
+        uint8_t header[kWavHeaderSize];
+        fillWavHeader(header, 0);
+        return std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    }
+
+   /**
+      Finish writing the file, returns false if anything failed since it was opened.
+    */
+    bool close()
+    {
+       #ifdef HAVE_FLAC
+        if (encoder != nullptr)
+        {
+            if (! FLAC__stream_encoder_finish(encoder))
+                failed = true;
+
+            FLAC__stream_encoder_delete(encoder);
+            encoder = nullptr;
+            return ! failed;
+        }
+       #endif
+
+        if (file == nullptr)
+            return true;
+
+        // patch sizes now that they are known, switching to RF64 if needed
+        uint8_t header[kWavHeaderSize];
+        fillWavHeader(header, numFramesWritten);
+
+        if (std::fseek(file, 0, SEEK_SET) != 0 || std::fwrite(header, 1, sizeof(header), file) != sizeof(header))
+            failed = true;
+
+        if (std::fclose(file) != 0)
+            failed = true;
+
+        file = nullptr;
+        return ! failed;
+    }
+
+   /**
+      Write @a frames frames from @a buffers, one per channel of the file.
+    */
+    bool write(const float* const* const buffers, const uint32_t frames)
+    {
+        if (failed || frames == 0)
+            return ! failed;
+
+        const uint32_t numChannels = info.numChannels;
+
+       #ifdef HAVE_FLAC
+        if (encoder != nullptr)
+        {
+            encoded.resize(static_cast<size_t>(frames) * numChannels);
+
+            FLAC__int32* channels[FLAC__MAX_CHANNELS];
+            for (uint32_t c = 0; c < numChannels; ++c)
+            {
+                channels[c] = encoded.data() + c * frames;
+
+                for (uint32_t i = 0; i < frames; ++i)
+                    channels[c][i] = floatToAudioFileInt(buffers[c][i], info.bitsPerSample);
+            }
+
+            if (! FLAC__stream_encoder_process(encoder, channels, frames))
+                failed = true;
+
+            numFramesWritten += frames;
+            return ! failed;
+        }
+       #endif
+
+        DISTRHO_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+        const uint32_t bytesPerSample = info.bitsPerSample / 8;
+        interleaved.resize(static_cast<size_t>(frames) * numChannels * bytesPerSample);
+        uint8_t* dst = interleaved.data();
+
+        if (info.isFloat)
+        {
+            for (uint32_t i = 0; i < frames; ++i)
+                for (uint32_t c = 0; c < numChannels; ++c, dst += sizeof(float))
+                    std::memcpy(dst, &buffers[c][i], sizeof(float));
+        }
+        else
+        {
+            for (uint32_t i = 0; i < frames; ++i)
+                for (uint32_t c = 0; c < numChannels; ++c, dst += bytesPerSample)
+                    writeAudioFileLE(dst, static_cast<uint32_t>(floatToAudioFileInt(buffers[c][i], info.bitsPerSample)),
+                                     bytesPerSample);
+        }
+
+        if (std::fwrite(interleaved.data(), 1, interleaved.size(), file) != interleaved.size())
+            failed = true;
+
+        numFramesWritten += frames;
+        return ! failed;
+    }
+
+    uint64_t getNumFramesWritten() const noexcept
+    {
+        return numFramesWritten;
+    }
+
+private:
+    AudioFileInfo info;
+    uint64_t numFramesWritten = 0;
+    bool failed = false;
+
+    FILE* file = nullptr;
+    std::vector<uint8_t> interleaved;
+
+    void fillWavHeader(uint8_t header[kWavHeaderSize], const uint64_t numFrames) const noexcept
+    {
+        const uint32_t bytesPerSample = info.bitsPerSample / 8;
+        const uint64_t dataSize = numFrames * info.numChannels * bytesPerSample;
+        const uint64_t riffSize = kWavHeaderSize - 8 + dataSize + (dataSize & 1);
+        const bool isRF64 = riffSize > 0xffffffff;
+
+        std::memcpy(header, isRF64 ? "RF64" : "RIFF", 4);
+        writeAudioFileLE(header + 4, isRF64 ? 0xffffffff : riffSize, 4);
+        std::memcpy(header + 8, "WAVE", 4);
+
+        // regular files keep this as a JUNK chunk, RF64 ones need it for the real sizes
+        uint8_t* const ds64 = header + 12;
+        std::memset(ds64, 0, 8 + 28);
+        std::memcpy(ds64, isRF64 ? "ds64" : "JUNK", 4);
+        writeAudioFileLE(ds64 + 4, 28, 4);
+
+        if (isRF64)
+        {
+            writeAudioFileLE(ds64 + 8, riffSize, 8);
+            writeAudioFileLE(ds64 + 16, dataSize, 8);
+            writeAudioFileLE(ds64 + 24, numFrames, 8);
+        }
+
+        uint8_t* const fmt = ds64 + 8 + 28;
+        std::memcpy(fmt, "fmt ", 4);
+        writeAudioFileLE(fmt + 4, 16, 4);
+        writeAudioFileLE(fmt + 8, info.isFloat ? 3 : 1, 2);
+        writeAudioFileLE(fmt + 10, info.numChannels, 2);
+        writeAudioFileLE(fmt + 12, info.sampleRate, 4);
+        writeAudioFileLE(fmt + 16, static_cast<uint64_t>(info.sampleRate) * info.numChannels * bytesPerSample, 4);
+        writeAudioFileLE(fmt + 20, info.numChannels * bytesPerSample, 2);
+        writeAudioFileLE(fmt + 22, info.bitsPerSample, 2);
+
+        uint8_t* const data = fmt + 8 + 16;
+        std::memcpy(data, "data", 4);
+        writeAudioFileLE(data + 4, isRF64 ? 0xffffffff : dataSize, 4);
+    }
+
+   #ifdef HAVE_FLAC
+    FLAC__StreamEncoder* encoder = nullptr;
+    std::vector<FLAC__int32> encoded;
+
+    bool openFlac(const char* const filename)
+    {
+        encoder = FLAC__stream_encoder_new();
+        DISTRHO_SAFE_ASSERT_RETURN(encoder != nullptr, false);
+
+        FLAC__stream_encoder_set_channels(encoder, info.numChannels);
+        FLAC__stream_encoder_set_bits_per_sample(encoder, info.bitsPerSample);
+        FLAC__stream_encoder_set_sample_rate(encoder, info.sampleRate);
+        FLAC__stream_encoder_set_compression_level(encoder, 5);
+        FLAC__stream_encoder_set_total_samples_estimate(encoder, info.numFrames);
+
+        if (FLAC__stream_encoder_init_file(encoder, filename, nullptr, nullptr) != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+        {
+            d_stderr2("Failed to create FLAC file '%s'", filename);
+            FLAC__stream_encoder_delete(encoder);
+            encoder = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+   #endif
+
+    DISTRHO_DECLARE_NON_COPYABLE(AudioFileWriter)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,124 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// planar multi-channel audio ring buffer, for use within a single thread
+// size is a power of 2 and positions are free-running, so they only need masking on access.
+// audio is read and written in place through contiguous spans, there are no intermediate copies,
+// and skipping audio without looking at it is only a position change.
+// there is no overflow or underflow checking, users must keep the distance between positions in range.
+
+class AudioRingBuffer
+{
+public:
+    AudioRingBuffer() noexcept = default;
+
+    ~AudioRingBuffer()
+    {
+        deleteBuffer();
+    }
+
+   /**
+      Allocate room for at least @a minFrames per channel, filled with silence.
+      Reading and writing starts at the same position.
+    */
+    void createBuffer(const uint32_t numChannels, const uint32_t minFrames)
+    {
+        deleteBuffer();
+
+        size = d_nextPowerOf2(minFrames);
+        mask = size - 1;
+        channels = numChannels;
+        buffer = new float[size * numChannels]();
+        readPos = writePos = 0;
+    }
+
+    void deleteBuffer()
+    {
+        delete[] buffer;
+        buffer = nullptr;
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+
+    float* getWritePointer(const uint32_t channel) const noexcept
+    {
+        return buffer + channel * size + (writePos & mask);
+    }
+
+   /**
+      Get how many frames can be written at getWritePointer() before wrapping around.
+    */
+    uint32_t getContiguousWriteFrames() const noexcept
+    {
+        return size - (writePos & mask);
+    }
+
+    void commitWrite(const uint32_t frames) noexcept
+    {
+        writePos += frames;
+    }
+
+   /**
+      Write @a frames of silence on all channels, wrapping around as needed.
+    */
+    void writeSilence(const uint32_t frames) noexcept
+    {
+        for (uint32_t done = 0; done != frames;)
+        {
+            const uint32_t span = std::min(frames - done, getContiguousWriteFrames());
+
+            for (uint32_t c = 0; c < channels; ++c)
+                std::memset(getWritePointer(c), 0, span * sizeof(float));
+
+            commitWrite(span);
+            done += span;
+        }
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+
+    const float* getReadPointer(const uint32_t channel) const noexcept
+    {
+        return buffer + channel * size + (readPos & mask);
+    }
+
+   /**
+      Get how many frames can be read from getReadPointer() before wrapping around.
+    */
+    uint32_t getContiguousReadFrames() const noexcept
+    {
+        return size - (readPos & mask);
+    }
+
+    void commitRead(const uint32_t frames) noexcept
+    {
+        readPos += frames;
+    }
+
+private:
+    float* buffer = nullptr;
+    uint32_t channels = 0;
+    uint32_t size = 0;
+    uint32_t mask = 0;
+    uint32_t readPos = 0;
+    uint32_t writePos = 0;
+
+    DISTRHO_DECLARE_NON_COPYABLE(AudioRingBuffer)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
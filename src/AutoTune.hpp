@@ -0,0 +1,325 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "extra/String.hpp"
+
+#include "DspTiming.hpp"
+#include "RNNoiseArch.hpp"
+
+#include "rnnoise.h"
+
+#include <cstdio>
+#include <vector>
+
+#if defined(RNN_ENABLE_X86_RTCD) && (defined(__GNUC__) || defined(__clang__))
+# include <cpuid.h>
+#elif defined(RNN_ENABLE_X86_RTCD) && defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
+#ifdef DISTRHO_OS_WINDOWS
+# include <direct.h>
+# include <windows.h>
+#else
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// one-time micro-benchmark of the RNNoise code paths supported by the CPU, picking the fastest one.
+// the winner is kept in a small per-user cache file, one line per CPU model and plugin version,
+// so only the first load on a machine pays for it (a fraction of a second), later ones just read the file.
+// a home directory shared by different machines ends up with a line for each of them.
+
+// audio processed per code path and round, in denoise blocks
+static constexpr const uint32_t kAutoTuneBlocks = 50;
+
+// the fastest of a few rounds is used, with code paths taking turns so that clock changes affect all of them
+static constexpr const uint32_t kAutoTuneRounds = 3;
+
+/**
+   Get the CPU model name, as reported by the CPU itself.
+   Returns an empty string if unknown, which disables caching.
+ */
+static inline String getAutoTuneCpuModel()
+{
+    char brand[49] = {};
+
+   #if defined(RNN_ENABLE_X86_RTCD) && (defined(__GNUC__) || defined(__clang__))
+    uint32_t regs[12];
+    if (__get_cpuid(0x80000002, &regs[0], &regs[1], &regs[2], &regs[3]) == 0
+        || __get_cpuid(0x80000003, &regs[4], &regs[5], &regs[6], &regs[7]) == 0
+        || __get_cpuid(0x80000004, &regs[8], &regs[9], &regs[10], &regs[11]) == 0)
+        return String();
+    std::memcpy(brand, regs, sizeof(regs));
+   #elif defined(RNN_ENABLE_X86_RTCD) && defined(_MSC_VER)
+    int regs[12];
+    __cpuid(&regs[0], 0x80000002);
+    __cpuid(&regs[4], 0x80000003);
+    __cpuid(&regs[8], 0x80000004);
+    std::memcpy(brand, regs, sizeof(regs));
+   #endif
+
+    // trimmed, and without tabs as those separate cache fields
+    char* start = brand;
+    while (*start == ' ')
+        ++start;
+
+    for (char* s = start; *s != '\0'; ++s)
+    {
+        if (*s == '\t' || *s == '\n')
+            *s = ' ';
+    }
+
+    for (size_t len = std::strlen(start); len != 0 && start[len - 1] == ' '; --len)
+        start[len - 1] = '\0';
+
+    return String(start);
+}
+
+/**
+   Get the cache directory, created if needed, or an empty string if there is no place for it.
+ */
+static inline String getAutoTuneCacheDir()
+{
+    String dir;
+
+   #ifdef DISTRHO_OS_WINDOWS
+    if (const char* const localAppData = std::getenv("LOCALAPPDATA"))
+    {
+        dir = localAppData;
+        dir += "\\ReNooice";
+        _mkdir(dir);
+    }
+   #else
+    const char* const home = std::getenv("HOME");
+    if (home == nullptr || home[0] == '\0')
+        return String();
+
+   #ifdef DISTRHO_OS_MAC
+    dir = home;
+    dir += "/Library/Caches/ReNooice";
+   #else
+    const char* const xdgCacheHome = std::getenv("XDG_CACHE_HOME");
+    if (xdgCacheHome != nullptr && xdgCacheHome[0] == '/')
+    {
+        dir = xdgCacheHome;
+    }
+    else
+    {
+        dir = home;
+        dir += "/.cache";
+    }
+    mkdir(dir, 0755);
+    dir += "/renooice";
+   #endif
+    mkdir(dir, 0755);
+   #endif
+
+    return dir;
+}
+
+/**
+   Look up the code path stored for @a key in cache file @a filename.
+   Returns kRNNoiseArchAuto if none is stored.
+ */
+static inline int readAutoTuneCache(const char* const filename, const char* const key)
+{
+    std::FILE* const f = std::fopen(filename, "r");
+    if (f == nullptr)
+        return kRNNoiseArchAuto;
+
+    int arch = kRNNoiseArchAuto;
+    const size_t keyLen = std::strlen(key);
+    char line[256];
+
+    // each line is "<version>\t<cpu model>\t<code path>"
+    while (std::fgets(line, sizeof(line), f) != nullptr)
+    {
+        if (std::strncmp(line, key, keyLen) != 0 || line[keyLen] != '\t')
+            continue;
+
+        char* const name = line + keyLen + 1;
+        name[std::strcspn(name, "\r\n")] = '\0';
+
+        if (! parseRNNoiseArchName(name, arch) || arch > getRNNoiseArchDetected())
+            arch = kRNNoiseArchAuto;
+        break;
+    }
+
+    std::fclose(f);
+    return arch;
+}
+
+/**
+   Store @a arch for @a key in cache file @a filename, keeping the lines of other keys.
+   Written to a temporary file first, so concurrent readers never see a partial file.
+ */
+static inline void writeAutoTuneCache(const char* const filename, const char* const key, const int arch)
+{
+    std::vector<String> lines;
+    const size_t keyLen = std::strlen(key);
+    char line[256];
+
+    if (std::FILE* const f = std::fopen(filename, "r"))
+    {
+        while (std::fgets(line, sizeof(line), f) != nullptr)
+        {
+            if (std::strchr(line, '\n') == nullptr)
+                continue;
+            if (std::strncmp(line, key, keyLen) == 0 && line[keyLen] == '\t')
+                continue;
+            lines.push_back(String(line));
+        }
+
+        std::fclose(f);
+    }
+
+    std::snprintf(line, sizeof(line), "%s\t%s\n", key, getRNNoiseArchName(arch));
+    lines.push_back(String(line));
+
+    String tmpFilename(filename);
+   #ifdef DISTRHO_OS_WINDOWS
+    std::snprintf(line, sizeof(line), ".%lu", static_cast<unsigned long>(GetCurrentProcessId()));
+   #else
+    std::snprintf(line, sizeof(line), ".%ld", static_cast<long>(getpid()));
+   #endif
+    tmpFilename += line;
+
+    std::FILE* const f = std::fopen(tmpFilename, "w");
+    DISTRHO_SAFE_ASSERT_RETURN(f != nullptr,);
+
+    bool ok = true;
+    for (const String& l : lines)
+        ok = std::fputs(l, f) >= 0 && ok;
+    ok = std::fclose(f) == 0 && ok;
+
+   #ifdef DISTRHO_OS_WINDOWS
+    ok = ok && MoveFileExA(tmpFilename, filename, MOVEFILE_REPLACE_EXISTING) != FALSE;
+   #else
+    ok = ok && std::rename(tmpFilename, filename) == 0;
+   #endif
+
+    if (! ok)
+        std::remove(tmpFilename);
+}
+
+/**
+   Time each code path supported by the CPU on the same noise input, and return the fastest one.
+   States are created through the tuned arch level, which is safe as nothing else creates them meanwhile.
+ */
+static inline int runAutoTuneBenchmark()
+{
+    std::vector<int> archs;
+    for (const RNNoiseArch arch : kRNNoiseArchs)
+    {
+        if (arch <= getRNNoiseArchDetected())
+            archs.push_back(arch);
+    }
+
+    std::vector<DenoiseState*> states(archs.size());
+    for (size_t i = 0; i < archs.size(); ++i)
+    {
+        getRNNoiseArchTuned().store(archs[i], std::memory_order_relaxed);
+        states[i] = rnnoise_create(nullptr);
+    }
+    getRNNoiseArchTuned().store(kRNNoiseArchAuto, std::memory_order_relaxed);
+
+    // low-passed noise at a moderate level, in the 16-bit scaling used for processing
+    const uint32_t frameSize = static_cast<uint32_t>(rnnoise_get_frame_size());
+    std::vector<float> input(frameSize * kAutoTuneBlocks);
+    std::vector<float> output(frameSize);
+    uint32_t seed = 1;
+    float noise = 0.f;
+
+    for (float& sample : input)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        noise = noise * 0.8f + (static_cast<float>(seed >> 8) / static_cast<float>(1 << 23) - 1.f) * 0.2f;
+        sample = noise * 3000.f;
+    }
+
+    std::vector<uint64_t> bestTimes(archs.size(), UINT64_MAX);
+
+    // an extra round first, so caches and clocks are warmed up before timing
+    for (uint32_t round = 0; round <= kAutoTuneRounds; ++round)
+    {
+        for (size_t i = 0; i < archs.size(); ++i)
+        {
+            DISTRHO_SAFE_ASSERT_CONTINUE(states[i] != nullptr);
+
+            const uint64_t timeStart = getMonotonicTimeNs();
+            for (uint32_t b = 0; b < kAutoTuneBlocks; ++b)
+                rnnoise_process_frame(states[i], output.data(), input.data() + frameSize * b);
+            const uint64_t time = getMonotonicTimeNs() - timeStart;
+
+            if (round != 0)
+                bestTimes[i] = std::min(bestTimes[i], time);
+        }
+    }
+
+    size_t best = 0;
+    for (size_t i = 0; i < archs.size(); ++i)
+    {
+        if (states[i] != nullptr)
+            rnnoise_destroy(states[i]);
+
+        if (bestTimes[i] < bestTimes[best])
+            best = i;
+
+        d_debug("Re:Nooice auto-tune: %s took %llu ns", getRNNoiseArchName(archs[i]),
+                static_cast<unsigned long long>(bestTimes[i]));
+    }
+
+    return archs[best];
+}
+
+/**
+   Pick the RNNoise code path for this machine, reading it from the cache or running the benchmark if not there.
+   Only does work on the first call per process, which other threads calling meanwhile wait for.
+   Does nothing if a code path was forced, or if there is nothing to choose from.
+   Must be called before creating denoise states, never from the audio thread.
+ */
+inline void applyRNNoiseAutoTune(const uint32_t version)
+{
+    static const bool done = [version]() -> bool {
+        if (getRNNoiseArchRequest().load(std::memory_order_relaxed) >= 0)
+            return false;
+        if (getRNNoiseArchDetected() == kRNNoiseArchGeneric)
+            return false;
+
+        const String cpuModel(getAutoTuneCpuModel());
+        const String cacheDir(cpuModel.isNotEmpty() ? getAutoTuneCacheDir() : String());
+
+        char key[128];
+        std::snprintf(key, sizeof(key), "%u.%u.%u\t%s",
+                      (version >> 16) & 0xff, (version >> 8) & 0xff, version & 0xff, cpuModel.buffer());
+
+        const String filename(cacheDir.isNotEmpty() ? cacheDir + DISTRHO_OS_SEP_STR "autotune" : String());
+        int arch = filename.isNotEmpty() ? readAutoTuneCache(filename, key) : kRNNoiseArchAuto;
+
+        if (arch < 0)
+        {
+            arch = runAutoTuneBenchmark();
+
+            if (filename.isNotEmpty())
+                writeAutoTuneCache(filename, key, arch);
+        }
+
+        getRNNoiseArchTuned().store(arch, std::memory_order_relaxed);
+        return true;
+    }();
+
+    (void)done;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
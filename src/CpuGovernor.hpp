@@ -0,0 +1,144 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// cpu budget governor, stepping down to cheaper processing while denoise blocks take longer than a given budget.
+// a level is dropped as soon as the smoothed load goes over budget, but only restored after a long stretch well
+// under it. the time to wait doubles each time a restored level turns out to be too expensive again,
+// so an instance that cannot afford full processing does not keep bouncing between levels.
+
+enum CpuGovernorLevel {
+    // processing as configured
+    kCpuGovernorFull = 0,
+    // inference skipped on silent input, same as the "Skip Idle Inference" parameter
+    kCpuGovernorSkipIdle,
+    // on top of that, the little builtin model
+    kCpuGovernorLittleModel,
+    kCpuGovernorLevelCount
+};
+
+class CpuGovernor
+{
+public:
+    // smoothing of block loads, as 1-pole filter coefficient per denoise block
+    static constexpr const double kSmoothing = 1.0 / 16;
+
+    // denoise blocks to wait after a level change before judging the new level, so the smoothed load can follow
+    static constexpr const uint32_t kSettleBlocks = 50;
+
+    // a level is restored once the load stays under this fraction of the budget for the restore time
+    static constexpr const double kRestoreRatio = 0.5;
+
+    // restore time in denoise blocks, from 3 seconds initially up to about 1.5 minutes after repeated failures
+    static constexpr const uint32_t kRestoreBlocks = 300;
+    static constexpr const uint32_t kRestoreBlocksMax = kRestoreBlocks * 32;
+
+    CpuGovernor() noexcept
+    {
+        reset();
+    }
+
+   /**
+      Set the budget, as a fraction of the real-time duration of a denoise block.
+    */
+    void setBudget(const double budgetLoad) noexcept
+    {
+        budget = budgetLoad;
+    }
+
+   /**
+      Go back to full processing and forget about past load.
+    */
+    void reset() noexcept
+    {
+        level = kCpuGovernorFull;
+        load = 0.0;
+        settleBlocks = 0;
+        underBlocks = 0;
+        restoreBlocks = kRestoreBlocks;
+        sinceRestore = UINT32_MAX;
+    }
+
+   /**
+      Feed the load of a denoise block, as a fraction of its real-time duration.
+      Returns the level to use from now on.
+    */
+    uint32_t process(const double blockLoad) noexcept
+    {
+        load += (blockLoad - load) * kSmoothing;
+
+        if (sinceRestore != UINT32_MAX && ++sinceRestore == restoreBlocks)
+        {
+            // restored level held up, next time can be quick again
+            restoreBlocks = kRestoreBlocks;
+            sinceRestore = UINT32_MAX;
+        }
+
+        if (settleBlocks != 0)
+        {
+            --settleBlocks;
+            return level;
+        }
+
+        if (load > budget)
+        {
+            underBlocks = 0;
+
+            if (level + 1 == kCpuGovernorLevelCount)
+                return level;
+
+            // restored too early, wait longer next time
+            if (sinceRestore != UINT32_MAX)
+                restoreBlocks = std::min(restoreBlocks * 2, static_cast<uint32_t>(kRestoreBlocksMax));
+
+            ++level;
+            settleBlocks = kSettleBlocks;
+            sinceRestore = UINT32_MAX;
+        }
+        else if (level != kCpuGovernorFull && load < budget * kRestoreRatio)
+        {
+            if (++underBlocks < restoreBlocks)
+                return level;
+
+            --level;
+            underBlocks = 0;
+            settleBlocks = kSettleBlocks;
+            sinceRestore = 0;
+        }
+        else
+        {
+            underBlocks = 0;
+        }
+
+        return level;
+    }
+
+    uint32_t getLevel() const noexcept
+    {
+        return level;
+    }
+
+private:
+    double budget = 1.0;
+    double load;
+    uint32_t level;
+    uint32_t settleBlocks;
+    uint32_t underBlocks;
+    uint32_t restoreBlocks;
+    uint32_t sinceRestore;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -4,6 +4,16 @@
  * SPDX-License-Identifier: ISC
  */
 
+/**
+   Whether to measure processing time of denoise blocks, reported through output parameters.
+   Can be removed at build time by passing NO_DSP_TIMING=true to make.
+ */
+#if !defined(SIMPLIFIED_NOOICE) && !defined(RENOOICE_NO_DSP_TIMING)
+#define RENOOICE_DSP_TIMING 1
+#else
+#define RENOOICE_DSP_TIMING 0
+#endif
+
 /**
    Parameters used by the plugin.
    Stored in a common header file for convenience
@@ -14,38 +24,143 @@ enum Parameters {
     kParamThreshold,
     kParamGracePeriod,
     kParamEnableStats,
+    kParamStatsShortWindow,
+    kParamStatsLongWindow,
+    kParamResampleQuality,
+    kParamWorkerThread,
+    kParamWorkerCPU,
+    kParamSkipInference,
+    kParamLittleModel,
+   #ifdef RENOOICE_ECHO_CANCEL
+    kParamEchoTail,
+   #endif
+   #if RENOOICE_DSP_TIMING
+    kParamResetTiming,
+    kParamGovernor,
+    kParamGovernorBudget,
+   #endif
     kParamCurrentVAD,
     kParamAverageVAD,
     kParamMinimumVAD,
     kParamMaximumVAD,
+    kParamShortAverageVAD,
+    kParamShortMinimumVAD,
+    kParamShortMaximumVAD,
+   #if RENOOICE_DSP_TIMING
+    kParamCurrentLoad,
+    kParamAverageLoad,
+    kParamWorstLoad,
+    kParamGovernorLevel,
+   #endif
+    kParamDeadlineMisses,
+    kParamSkippedFrames,
+    kParamVisualization,
    #endif
     kParamCount,
 };
 
+/**
+   States used by the plugin.
+ */
+enum States {
+    kStateModel,
+    kStateCount,
+};
+
+/**
+   Resampling quality, used when the host does not run at 48kHz.
+   Lower quality means shorter filters and less latency.
+ */
+enum ResampleQuality {
+    kResampleQualityLowLatency,
+    kResampleQualityVoIP,
+    kResampleQualityDesktop,
+    kResampleQualityHigh,
+};
+
+/**
+   Number of audio channels processed by the plugin.
+   The regular build is mono, multichannel variants are built by setting this macro from the Makefile.
+ */
+#ifndef RENOOICE_NUM_CHANNELS
+#define RENOOICE_NUM_CHANNELS 1
+#endif
+
+/**
+   Echo cancelling variant, built by passing ECHO_CANCEL=true to make.
+   It takes the far-end reference as an extra input, cancelling its echo before denoise on the same blocks.
+ */
+#ifdef RENOOICE_ECHO_CANCEL
+#if RENOOICE_NUM_CHANNELS != 1
+#error echo cancellation is only available for the mono variant
+#endif
+#define RENOOICE_LABEL "ReNooiceAEC"
+#define RENOOICE_NAME_SUFFIX " AEC"
+#define RENOOICE_ID_SUFFIX "_aec"
+#define RENOOICE_UNIQUE_ID rNoE
+#define RENOOICE_CLAP_FEATURE "mono"
+#define RENOOICE_VST3_CATEGORY "Mono"
+#elif RENOOICE_NUM_CHANNELS == 1
+#define RENOOICE_LABEL "ReNooice"
+#define RENOOICE_NAME_SUFFIX ""
+#define RENOOICE_ID_SUFFIX ""
+#define RENOOICE_UNIQUE_ID rNoi
+#define RENOOICE_CLAP_FEATURE "mono"
+#define RENOOICE_VST3_CATEGORY "Mono"
+#elif RENOOICE_NUM_CHANNELS == 2
+#define RENOOICE_LABEL "ReNooiceStereo"
+#define RENOOICE_NAME_SUFFIX " Stereo"
+#define RENOOICE_ID_SUFFIX "_stereo"
+#define RENOOICE_UNIQUE_ID rNo2
+#define RENOOICE_CLAP_FEATURE "stereo"
+#define RENOOICE_VST3_CATEGORY "Stereo"
+#elif RENOOICE_NUM_CHANNELS == 4
+#define RENOOICE_LABEL "ReNooiceQuad"
+#define RENOOICE_NAME_SUFFIX " Quad"
+#define RENOOICE_ID_SUFFIX "_quad"
+#define RENOOICE_UNIQUE_ID rNo4
+#define RENOOICE_CLAP_FEATURE "surround"
+#define RENOOICE_VST3_CATEGORY "Surround"
+#elif RENOOICE_NUM_CHANNELS == 8
+#define RENOOICE_LABEL "ReNooice8ch"
+#define RENOOICE_NAME_SUFFIX " 8ch"
+#define RENOOICE_ID_SUFFIX "_8ch"
+#define RENOOICE_UNIQUE_ID rNo8
+#define RENOOICE_CLAP_FEATURE "surround"
+#define RENOOICE_VST3_CATEGORY "Surround"
+#else
+#error unsupported RENOOICE_NUM_CHANNELS value
+#endif
+
 /**
    The plugin name.
    This is used to identify your plugin before a Plugin instance can be created.
    @note This macro is required.
  */
-#define DISTRHO_PLUGIN_NAME "Re:Nooice"
+#define DISTRHO_PLUGIN_NAME "Re:Nooice" RENOOICE_NAME_SUFFIX
 
 /**
    Number of audio inputs the plugin has.
+   The echo cancelling variant has the far-end reference as last input.
    @note This macro is required.
  */
-#define DISTRHO_PLUGIN_NUM_INPUTS 1
+#ifdef RENOOICE_ECHO_CANCEL
+#define DISTRHO_PLUGIN_NUM_INPUTS (RENOOICE_NUM_CHANNELS + 1)
+#else
+#define DISTRHO_PLUGIN_NUM_INPUTS RENOOICE_NUM_CHANNELS
+#endif
 
 /**
    Number of audio outputs the plugin has.
    @note This macro is required.
  */
-#define DISTRHO_PLUGIN_NUM_OUTPUTS 1
+#define DISTRHO_PLUGIN_NUM_OUTPUTS RENOOICE_NUM_CHANNELS
 
 /**
    The plugin URI when exporting in LV2 format.
    @note This macro is required.
  */
-#define DISTRHO_PLUGIN_URI "urn:distrho:renooice"
+#define DISTRHO_PLUGIN_URI "urn:distrho:renooice" RENOOICE_ID_SUFFIX
 
 /**
    Whether the plugin has a custom %UI.
@@ -113,7 +228,7 @@ enum Parameters {
    @see Plugin::initState(uint32_t, String&, String&)
    @see Plugin::setState(const char*, const char*)
  */
-#define DISTRHO_PLUGIN_WANT_STATE 0
+#define DISTRHO_PLUGIN_WANT_STATE 1
 
 /**
    Whether the plugin implements the full state API.
@@ -173,7 +288,7 @@ enum Parameters {
 
    When this macro is defined, the companion DISTRHO_UI_DEFAULT_WIDTH macro must be defined as well.
  */
-#define DISTRHO_UI_DEFAULT_HEIGHT 431
+#define DISTRHO_UI_DEFAULT_HEIGHT 539
 
 /**
    Whether the %UI uses NanoVG for drawing instead of the default raw OpenGL calls.
@@ -209,7 +324,7 @@ enum Parameters {
    It must be unique within at least a set of plugins from the brand.
    @note This macro is required when building AU plugins
  */
-#define DISTRHO_PLUGIN_UNIQUE_ID rNoi
+#define DISTRHO_PLUGIN_UNIQUE_ID RENOOICE_UNIQUE_ID
 
 /**
    Custom LV2 category for the plugin.
@@ -300,7 +415,7 @@ enum Parameters {
       - Mono
       - Stereo
  */
-#define DISTRHO_PLUGIN_VST3_CATEGORIES "Fx|Tools|Mono"
+#define DISTRHO_PLUGIN_VST3_CATEGORIES "Fx|Tools|" RENOOICE_VST3_CATEGORY
 
 /**
    Custom CLAP features for the plugin.
@@ -358,10 +473,10 @@ enum Parameters {
       - surround
       - ambisonic
 */
-#define DISTRHO_PLUGIN_CLAP_FEATURES "audio-effect", "mono"
+#define DISTRHO_PLUGIN_CLAP_FEATURES "audio-effect", RENOOICE_CLAP_FEATURE
 
 /**
    The plugin id when exporting in CLAP format, in reverse URI form.
    @note This macro is required when building CLAP plugins
 */
-#define DISTRHO_PLUGIN_CLAP_ID "studio.kx.distrho.renooice"
+#define DISTRHO_PLUGIN_CLAP_ID "studio.kx.distrho.renooice" RENOOICE_ID_SUFFIX
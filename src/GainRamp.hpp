@@ -0,0 +1,254 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#if defined(__AVX__)
+# include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// linear value smoother that can hand out whole blocks of its ramp at once
+// behaves like DPF LinearValueSmoother (every target change ramps over the time constant, starting from the current
+// value), but keeps track of the frames left until the target, so gains can be applied per block instead of per frame
+
+class BlockValueSmoother
+{
+public:
+    BlockValueSmoother() noexcept = default;
+
+    void setSampleRate(const float newSampleRate) noexcept
+    {
+        if (d_isEqual(sampleRate, newSampleRate))
+            return;
+
+        const float current = getCurrentValue();
+        sampleRate = newSampleRate;
+        updateRamp(current);
+    }
+
+    void setTimeConstant(const float newTimeConstant) noexcept
+    {
+        const float current = getCurrentValue();
+        timeConstant = newTimeConstant;
+        updateRamp(current);
+    }
+
+    void setTargetValue(const float newTarget) noexcept
+    {
+        if (d_isEqual(target, newTarget))
+            return;
+
+        const float current = getCurrentValue();
+        target = newTarget;
+        updateRamp(current);
+    }
+
+    float getCurrentValue() const noexcept
+    {
+        return target - step * framesLeft;
+    }
+
+    float getTargetValue() const noexcept
+    {
+        return target;
+    }
+
+    void clearToTargetValue() noexcept
+    {
+        framesLeft = 0;
+    }
+
+   /**
+      Get how many frames are left until reaching the target value, 0 if already there.
+    */
+    uint32_t getRampFrames() const noexcept
+    {
+        return framesLeft;
+    }
+
+   /**
+      Get the gain ramp for the next @a frames frames and move past it.
+      The value for frame i is @a start + @a increment * i.
+      @a frames must not be more than getRampFrames().
+    */
+    void nextRamp(const uint32_t frames, float& start, float& increment) noexcept
+    {
+        start = target - step * (framesLeft - 1);
+        increment = step;
+        framesLeft -= frames;
+    }
+
+    float next() noexcept
+    {
+        if (framesLeft != 0)
+            --framesLeft;
+
+        return getCurrentValue();
+    }
+
+private:
+    float sampleRate = 0.f;
+    float timeConstant = 0.f;
+    float target = 0.f;
+    float step = 0.f;
+    uint32_t framesLeft = 0;
+
+    // restart ramp from @a current value, as the current value depends on the old ramp
+    void updateRamp(const float current) noexcept
+    {
+        const uint32_t rampFrames = d_roundToUnsignedInt(timeConstant * sampleRate);
+
+        if (rampFrames == 0 || d_isEqual(current, target))
+        {
+            step = 0.f;
+            framesLeft = 0;
+            return;
+        }
+
+        step = (target - current) / rampFrames;
+        framesLeft = rampFrames;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// block-wise gain kernels, for constant gains and linear ramps
+// ramps are computed from the frame index instead of accumulated, so vector and scalar code give the same values
+
+#if defined(__AVX__)
+struct GainVector {
+    static constexpr const uint32_t kWidth = 8;
+    typedef __m256 Type;
+    static Type load(const float* const p) noexcept { return _mm256_loadu_ps(p); }
+    static void store(float* const p, const Type v) noexcept { _mm256_storeu_ps(p, v); }
+    static Type set(const float v) noexcept { return _mm256_set1_ps(v); }
+    static Type add(const Type a, const Type b) noexcept { return _mm256_add_ps(a, b); }
+    static Type sub(const Type a, const Type b) noexcept { return _mm256_sub_ps(a, b); }
+    static Type mul(const Type a, const Type b) noexcept { return _mm256_mul_ps(a, b); }
+    static Type lanes() noexcept { return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f); }
+};
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+struct GainVector {
+    static constexpr const uint32_t kWidth = 4;
+    typedef __m128 Type;
+    static Type load(const float* const p) noexcept { return _mm_loadu_ps(p); }
+    static void store(float* const p, const Type v) noexcept { _mm_storeu_ps(p, v); }
+    static Type set(const float v) noexcept { return _mm_set1_ps(v); }
+    static Type add(const Type a, const Type b) noexcept { return _mm_add_ps(a, b); }
+    static Type sub(const Type a, const Type b) noexcept { return _mm_sub_ps(a, b); }
+    static Type mul(const Type a, const Type b) noexcept { return _mm_mul_ps(a, b); }
+    static Type lanes() noexcept { return _mm_setr_ps(0.f, 1.f, 2.f, 3.f); }
+};
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+struct GainVector {
+    static constexpr const uint32_t kWidth = 4;
+    typedef float32x4_t Type;
+    static Type load(const float* const p) noexcept { return vld1q_f32(p); }
+    static void store(float* const p, const Type v) noexcept { vst1q_f32(p, v); }
+    static Type set(const float v) noexcept { return vdupq_n_f32(v); }
+    static Type add(const Type a, const Type b) noexcept { return vaddq_f32(a, b); }
+    static Type sub(const Type a, const Type b) noexcept { return vsubq_f32(a, b); }
+    static Type mul(const Type a, const Type b) noexcept { return vmulq_f32(a, b); }
+    static Type lanes() noexcept { static const float l[4] = { 0.f, 1.f, 2.f, 3.f }; return vld1q_f32(l); }
+};
+#else
+// scalar only, vector loops below are skipped
+# define RENOOICE_NO_GAIN_VECTOR
+#endif
+
+/**
+   Copy @a frames from @a src into @a dst, multiplied by a constant @a gain.
+ */
+static inline
+void copyWithGain(float* const dst, const float* const src, const uint32_t frames, const float gain) noexcept
+{
+    uint32_t i = 0;
+
+   #ifndef RENOOICE_NO_GAIN_VECTOR
+    const GainVector::Type g = GainVector::set(gain);
+
+    for (; i + GainVector::kWidth <= frames; i += GainVector::kWidth)
+        GainVector::store(dst + i, GainVector::mul(GainVector::load(src + i), g));
+   #endif
+
+    for (; i < frames; ++i)
+        dst[i] = src[i] * gain;
+}
+
+/**
+   Multiply @a frames of @a buffer by a constant @a gain, in place.
+ */
+static inline
+void applyGain(float* const buffer, const uint32_t frames, const float gain) noexcept
+{
+    copyWithGain(buffer, buffer, frames, gain);
+}
+
+/**
+   Multiply @a frames of @a buffer by a linear gain ramp, in place.
+   Frame i is multiplied by @a start + @a increment * i.
+ */
+static inline
+void applyGainRamp(float* const buffer, const uint32_t frames, const float start, const float increment) noexcept
+{
+    uint32_t i = 0;
+
+   #ifndef RENOOICE_NO_GAIN_VECTOR
+    const GainVector::Type s = GainVector::set(start);
+    const GainVector::Type inc = GainVector::set(increment);
+    const GainVector::Type lanes = GainVector::lanes();
+
+    for (; i + GainVector::kWidth <= frames; i += GainVector::kWidth)
+    {
+        const GainVector::Type index = GainVector::add(GainVector::set(static_cast<float>(i)), lanes);
+        const GainVector::Type g = GainVector::add(s, GainVector::mul(inc, index));
+        GainVector::store(buffer + i, GainVector::mul(GainVector::load(buffer + i), g));
+    }
+   #endif
+
+    for (; i < frames; ++i)
+        buffer[i] *= start + increment * static_cast<float>(i);
+}
+
+/**
+   Crossfade @a frames from @a a to @a b into @a out, following a linear ramp for the amount of @a b.
+   Frame i gets @a start + @a increment * i of @a b, and the rest of @a a.
+ */
+static inline
+void mixWithGainRamp(float* const out, const float* const a, const float* const b,
+                     const uint32_t frames, const float start, const float increment) noexcept
+{
+    uint32_t i = 0;
+
+   #ifndef RENOOICE_NO_GAIN_VECTOR
+    const GainVector::Type s = GainVector::set(start);
+    const GainVector::Type inc = GainVector::set(increment);
+    const GainVector::Type lanes = GainVector::lanes();
+
+    for (; i + GainVector::kWidth <= frames; i += GainVector::kWidth)
+    {
+        const GainVector::Type index = GainVector::add(GainVector::set(static_cast<float>(i)), lanes);
+        const GainVector::Type g = GainVector::add(s, GainVector::mul(inc, index));
+        const GainVector::Type va = GainVector::load(a + i);
+        GainVector::store(out + i, GainVector::add(va, GainVector::mul(GainVector::sub(GainVector::load(b + i), va), g)));
+    }
+   #endif
+
+    for (; i < frames; ++i)
+        out[i] = a[i] + (b[i] - a[i]) * (start + increment * static_cast<float>(i));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,95 @@
+#!/usr/bin/make -f
+# Re:Nooice DSP sources and build flags, shared by the plugin, benchmarks and tools
+# SPDX-License-Identifier: ISC
+#
+# include after Makefile.base.mk and setting CHANNELS or ECHO_CANCEL if needed,
+# then add FILES_RENOOICE_DSP to the files to build and RENOOICE_DSP_FLAGS to BASE_FLAGS.
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Directory setup, relative to the including makefile
+# sources from this directory have no prefix when included from here, so plugin objects keep their usual place
+
+RENOOICE_SRC_PATH := $(filter-out ./,$(dir $(lastword $(MAKEFILE_LIST))))
+RENOOICE_ROOT_PATH := $(if $(RENOOICE_SRC_PATH),$(RENOOICE_SRC_PATH:%src/=%),../)
+RNNOISE_PATH = $(RENOOICE_ROOT_PATH)deps/rnnoise
+
+include $(RENOOICE_ROOT_PATH)deps/Makefile.speexdsp.mk
+
+ifeq ($(CPU_I386_OR_X86_64),true)
+ifneq ($(WASM),true)
+X86_RTCD = true
+endif
+endif
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Files to build
+
+FILES_RENOOICE_DSP = \
+	$(RENOOICE_SRC_PATH)PluginDSP.cpp \
+	$(RENOOICE_SRC_PATH)RNNoiseLittleData.c \
+	$(RENOOICE_SRC_PATH)RNNoiseLittleDenoise.c \
+	$(RENOOICE_SRC_PATH)RNNoiseLittleRnn.c \
+	$(RNNOISE_PATH)/src/celt_lpc.c \
+	$(RNNOISE_PATH)/src/denoise.c \
+	$(RNNOISE_PATH)/src/kiss_fft.c \
+	$(RNNOISE_PATH)/src/nnet.c \
+	$(RNNOISE_PATH)/src/nnet_default.c \
+	$(RNNOISE_PATH)/src/parse_lpcnet_weights.c \
+	$(RNNOISE_PATH)/src/pitch.c \
+	$(RNNOISE_PATH)/src/rnn.c \
+	$(RNNOISE_PATH)/src/rnnoise_data.c \
+	$(RNNOISE_PATH)/src/rnnoise_tables.c \
+	$(FILES_SPEEXDSP_RESAMPLER)
+
+ifeq ($(X86_RTCD),true)
+FILES_RENOOICE_DSP += \
+	$(RNNOISE_PATH)/src/x86/nnet_avx2.c \
+	$(RNNOISE_PATH)/src/x86/nnet_sse4_1.c \
+	$(RNNOISE_PATH)/src/x86/x86cpu.c \
+	$(RNNOISE_PATH)/src/x86/x86_dnn_map.c
+endif
+
+# speex echo canceller, applied before denoise on the same blocks
+ifeq ($(ECHO_CANCEL),true)
+FILES_RENOOICE_DSP += $(FILES_SPEEXDSP_ECHO)
+endif
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Build flags
+
+RENOOICE_DSP_FLAGS = -DDISABLE_DEBUG_FLOAT
+RENOOICE_DSP_FLAGS += -DFLOAT_APPROX
+RENOOICE_DSP_FLAGS += -DRNNOISE_EXPORT=
+RENOOICE_DSP_FLAGS += -I$(RNNOISE_PATH)/include
+RENOOICE_DSP_FLAGS += -I$(RNNOISE_PATH)/src
+RENOOICE_DSP_FLAGS += $(SPEEXDSP_FLAGS)
+RENOOICE_DSP_FLAGS += -I$(RENOOICE_ROOT_PATH)common
+
+ifneq ($(RENOOICE_SRC_PATH),)
+RENOOICE_DSP_FLAGS += -I$(RENOOICE_SRC_PATH)
+endif
+
+ifneq ($(CHANNELS),)
+RENOOICE_DSP_FLAGS += -DRENOOICE_NUM_CHANNELS=$(CHANNELS)
+endif
+
+ifeq ($(ECHO_CANCEL),true)
+RENOOICE_DSP_FLAGS += -DRENOOICE_ECHO_CANCEL
+endif
+
+ifeq ($(NO_DSP_TIMING),true)
+RENOOICE_DSP_FLAGS += -DRENOOICE_NO_DSP_TIMING
+endif
+
+ifeq ($(X86_RTCD),true)
+RENOOICE_DSP_FLAGS += -DCPU_INFO_BY_ASM -DRNN_ENABLE_X86_RTCD
+
+%/rnnoise/src/x86/nnet_avx2.c.o: BASE_FLAGS += -mavx -mfma -mavx2
+
+%/rnnoise/src/x86/nnet_sse4_1.c.o: BASE_FLAGS += -msse4.1
+
+# the plugin provides rnn_select_arch, so the code path can be forced (see RNNoiseArch.hpp)
+%/rnnoise/src/x86/x86cpu.c.o: BASE_FLAGS += -Drnn_select_arch=rnn_select_arch_detected
+endif
+
+# ---------------------------------------------------------------------------------------------------------------------
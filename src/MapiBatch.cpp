@@ -0,0 +1,321 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#include "DistrhoUtils.hpp"
+#include "extra/Thread.hpp"
+
+#include "MapiBatch.h"
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+// --------------------------------------------------------------------------------------------------------------------
+// regular mapi entry points, provided by the DPF MAPI wrapper within the same library
+
+typedef void* mapi_handle_t;
+
+extern "C" {
+mapi_handle_t mapi_create(unsigned int sample_rate);
+void mapi_process(mapi_handle_t handle, const float* const* ins, float** outs, unsigned int frames);
+void mapi_destroy(mapi_handle_t handle);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// batch of denoise streams processed by a fixed thread pool
+// each thread owns a contiguous range of streams, threads that finish early steal streams from the others.
+// streams are claimed one at a time through atomic counters, so a tick needs no locking besides waking up threads.
+
+struct MapiReNooiceBatch
+{
+    static constexpr const uintptr_t kCacheLineSize = 64;
+
+    // range of streams owned by a thread, kept on its own cache line
+    struct alignas(kCacheLineSize) Partition {
+        std::atomic<uint32_t> next;
+        uint32_t end;
+    };
+    static_assert(sizeof(Partition) == kCacheLineSize, "partitions must not share cache lines");
+
+    class Worker : public DISTRHO::Thread
+    {
+    public:
+        Worker(MapiReNooiceBatch& b, const uint32_t i)
+            : Thread("ReNooice batch"),
+              batch(b),
+              index(i) {}
+
+        void wakeUp() noexcept
+        {
+            signal.signal();
+        }
+
+        void stop()
+        {
+            signalThreadShouldExit();
+            signal.signal();
+            stopThread(-1);
+        }
+
+    protected:
+        void run() override
+        {
+            for (;;)
+            {
+                signal.wait();
+
+                if (shouldThreadExit())
+                    break;
+
+                batch.work(index);
+
+                // last one out lets the calling thread know the tick is done
+                if (batch.workersBusy.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    batch.done.signal();
+            }
+        }
+
+    private:
+        MapiReNooiceBatch& batch;
+        const uint32_t index;
+        DISTRHO::Signal signal;
+    };
+
+    const uint32_t numStreams;
+    const uint32_t numThreads;
+    const uint32_t maxFrames;
+
+    // stream handles, plus per-stream planar scratch for interleaved processing (input and output, maxFrames each)
+    mapi_handle_t* const streams;
+    float* const scratch;
+
+    // one partition per thread, the calling thread being the first one.
+    // plain new only guarantees the default alignment, so they are placed within a slightly larger allocation.
+    char* const partitionStorage;
+    Partition* const partitions;
+    Worker** const workers;
+    std::atomic<uint32_t> workersBusy { 0 };
+    DISTRHO::Signal done;
+
+    // current tick, only set by the calling thread while workers are idle
+    const float* const* tickInputs = nullptr;
+    float* const* tickOutputs = nullptr;
+    const float* tickInterleaved = nullptr;
+    uint32_t tickFrames = 0;
+
+    MapiReNooiceBatch(const uint32_t streamCount, const uint32_t threadCount, const uint32_t frames)
+        : numStreams(streamCount),
+          numThreads(threadCount),
+          maxFrames(frames),
+          streams(new mapi_handle_t[streamCount]()),
+          scratch(new float[streamCount * frames * 2]),
+          partitionStorage(new char[sizeof(Partition) * threadCount + kCacheLineSize - 1]),
+          partitions(createPartitions(partitionStorage, threadCount)),
+          workers(new Worker*[threadCount]()) {}
+
+    ~MapiReNooiceBatch()
+    {
+        for (uint32_t t = 1; t < numThreads; ++t)
+        {
+            if (workers[t] != nullptr)
+            {
+                workers[t]->stop();
+                delete workers[t];
+            }
+        }
+
+        for (uint32_t s = 0; s < numStreams; ++s)
+        {
+            if (streams[s] != nullptr)
+                mapi_destroy(streams[s]);
+        }
+
+        delete[] streams;
+        delete[] scratch;
+        delete[] partitionStorage;
+        delete[] workers;
+    }
+
+   /**
+      Construct @a count partitions at the first cache line boundary within @a storage.
+    */
+    static Partition* createPartitions(char* const storage, const uint32_t count) noexcept
+    {
+        const uintptr_t address = (reinterpret_cast<uintptr_t>(storage) + kCacheLineSize - 1) & ~(kCacheLineSize - 1);
+        Partition* const parts = reinterpret_cast<Partition*>(address);
+
+        for (uint32_t t = 0; t < count; ++t)
+            new (parts + t) Partition();
+
+        return parts;
+    }
+
+   /**
+      Process a tick for all streams, from either planar or interleaved buffers.
+      Returns once all streams are done.
+    */
+    void process(const float* const* const inputs, float* const* const outputs,
+                 const float* const interleaved, const uint32_t frames)
+    {
+        tickInputs = inputs;
+        tickOutputs = outputs;
+        tickInterleaved = interleaved;
+        tickFrames = frames;
+
+        for (uint32_t t = 0; t < numThreads; ++t)
+            partitions[t].next.store(numStreams * t / numThreads, std::memory_order_relaxed);
+
+        workersBusy.store(numThreads - 1, std::memory_order_relaxed);
+
+        for (uint32_t t = 1; t < numThreads; ++t)
+            workers[t]->wakeUp();
+
+        work(0);
+
+        if (numThreads != 1)
+            done.wait();
+    }
+
+   /**
+      Process streams owned by thread @a self, then help out the others.
+    */
+    void work(const uint32_t self)
+    {
+        for (uint32_t i = 0; i < numThreads; ++i)
+        {
+            Partition& partition(partitions[(self + i) % numThreads]);
+
+            for (uint32_t s; (s = partition.next.fetch_add(1, std::memory_order_relaxed)) < partition.end;)
+                processStream(s);
+        }
+    }
+
+    void processStream(const uint32_t s)
+    {
+        if (tickInterleaved != nullptr)
+        {
+            float* in = scratch + s * maxFrames * 2;
+            float* out = in + maxFrames;
+
+            for (uint32_t i = 0; i < tickFrames; ++i)
+                in[i] = tickInterleaved[i * numStreams + s];
+
+            mapi_process(streams[s], &in, &out, tickFrames);
+        }
+        else
+        {
+            float* out = tickOutputs[s];
+            mapi_process(streams[s], tickInputs + s, &out, tickFrames);
+        }
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(MapiReNooiceBatch)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+DISTRHO_PLUGIN_EXPORT
+mapi_renooice_batch_t mapi_renooice_batch_create(const unsigned int sample_rate,
+                                                 const unsigned int num_streams,
+                                                 const unsigned int num_threads,
+                                                 const unsigned int max_frames)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(sample_rate != 0, nullptr);
+    DISTRHO_SAFE_ASSERT_RETURN(num_streams != 0, nullptr);
+    DISTRHO_SAFE_ASSERT_RETURN(max_frames != 0, nullptr);
+
+    uint32_t numThreads = num_threads != 0 ? num_threads : std::thread::hardware_concurrency();
+
+    // more threads than streams would only sit idle
+    if (numThreads == 0)
+        numThreads = 1;
+    else if (numThreads > num_streams)
+        numThreads = num_streams;
+
+    MapiReNooiceBatch* const batch = new MapiReNooiceBatch(num_streams, numThreads, max_frames);
+
+    for (uint32_t s = 0; s < num_streams; ++s)
+    {
+        if ((batch->streams[s] = mapi_create(sample_rate)) == nullptr)
+        {
+            d_stderr2("Failed to create denoise stream %u of %u", s + 1, num_streams);
+            delete batch;
+            return nullptr;
+        }
+    }
+
+    for (uint32_t t = 0; t < numThreads; ++t)
+        batch->partitions[t].end = num_streams * (t + 1) / numThreads;
+
+    for (uint32_t t = 1; t < numThreads; ++t)
+    {
+        batch->workers[t] = new MapiReNooiceBatch::Worker(*batch, t);
+        batch->workers[t]->startThread();
+    }
+
+    return batch;
+}
+
+DISTRHO_PLUGIN_EXPORT
+void* mapi_renooice_batch_get_stream(const mapi_renooice_batch_t batch, const unsigned int index)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(batch != nullptr, nullptr);
+    DISTRHO_SAFE_ASSERT_RETURN(index < batch->numStreams, nullptr);
+
+    return batch->streams[index];
+}
+
+DISTRHO_PLUGIN_EXPORT
+void mapi_renooice_batch_process(const mapi_renooice_batch_t batch,
+                                 const float* const* const inputs,
+                                 float* const* const outputs,
+                                 const unsigned int frames)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(batch != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(inputs != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(outputs != nullptr,);
+
+    if (frames == 0)
+        return;
+
+    batch->process(inputs, outputs, nullptr, frames);
+}
+
+DISTRHO_PLUGIN_EXPORT
+void mapi_renooice_batch_process_interleaved(const mapi_renooice_batch_t batch,
+                                             const float* const input,
+                                             float* const output,
+                                             const unsigned int frames)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(batch != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(input != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(output != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(frames <= batch->maxFrames,);
+
+    if (frames == 0)
+        return;
+
+    batch->process(nullptr, nullptr, input, frames);
+
+    // interleave output once all threads are done, so they do not fight over the same cache lines
+    const uint32_t numStreams = batch->numStreams;
+
+    for (uint32_t s = 0; s < numStreams; ++s)
+    {
+        const float* const out = batch->scratch + (s * batch->maxFrames * 2) + batch->maxFrames;
+
+        for (uint32_t i = 0; i < frames; ++i)
+            output[i * numStreams + s] = out[i];
+    }
+}
+
+DISTRHO_PLUGIN_EXPORT
+void mapi_renooice_batch_destroy(const mapi_renooice_batch_t batch)
+{
+    delete batch;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
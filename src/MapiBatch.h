@@ -0,0 +1,62 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#ifndef MAPI_RENOOICE_BATCH_H_INCLUDED
+#define MAPI_RENOOICE_BATCH_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+// multi-stream batch API, part of the mapi shared library
+// owns a number of independent mono denoise streams and processes a whole tick for all of them in one call,
+// spread over a fixed pool of threads.
+
+typedef struct MapiReNooiceBatch* mapi_renooice_batch_t;
+
+/**
+   Create a batch of @a num_streams denoise streams running at @a sample_rate.
+   Processing is spread over @a num_threads threads including the calling one, 0 meaning one per CPU core.
+   Ticks can be up to @a max_frames frames long.
+   Returns null on failure.
+ */
+mapi_renooice_batch_t mapi_renooice_batch_create(unsigned int sample_rate,
+                                                 unsigned int num_streams,
+                                                 unsigned int num_threads,
+                                                 unsigned int max_frames);
+
+/**
+   Get the regular mapi handle of a single stream, for use with mapi_set_parameter and mapi_set_state.
+   Must not be used while a tick is being processed.
+ */
+void* mapi_renooice_batch_get_stream(mapi_renooice_batch_t batch, unsigned int index);
+
+/**
+   Process a tick of @a frames frames for all streams, from planar buffers with one pointer per stream.
+ */
+void mapi_renooice_batch_process(mapi_renooice_batch_t batch,
+                                 const float* const* inputs,
+                                 float* const* outputs,
+                                 unsigned int frames);
+
+/**
+   Process a tick of @a frames frames for all streams, from interleaved buffers with one sample per stream per frame.
+ */
+void mapi_renooice_batch_process_interleaved(mapi_renooice_batch_t batch,
+                                             const float* input,
+                                             float* output,
+                                             unsigned int frames);
+
+void mapi_renooice_batch_destroy(mapi_renooice_batch_t batch);
+
+// --------------------------------------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAPI_RENOOICE_BATCH_H_INCLUDED
@@ -0,0 +1,127 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "GainRamp.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// voice activity gate of a single channel, applied together with the scaling back from denoise levels.
+// voice activity over the threshold opens the gate, it closes once the grace period after the last one runs out.
+// the gain kernels are specialized on the frame size and on what can happen within the block,
+// so the common cases run as a single gain or ramp over the whole block.
+
+struct MuteGate {
+    // smooth mute/unmute, 0 is muted and 1 is open
+    BlockValueSmoother value;
+
+    // frames left until the grace period runs out, counted at denoise rate, 0 when not running
+    uint32_t graceFrames = 0;
+
+   /**
+      Check if the gate is fully open, not moving and with no grace period about to run out.
+      With the threshold at 0 such a gate stays open, so only scaling is needed.
+    */
+    template <uint32_t kFrameSize>
+    bool isSettledOpen(const uint32_t gracePeriodInFrames) const noexcept
+    {
+        return value.getTargetValue() == 1.f
+            && value.getRampFrames() == 0
+            && (gracePeriodInFrames == 0 || gracePeriodInFrames > kFrameSize);
+    }
+};
+
+/**
+   Apply the gain of @a gate times @a scaling to a block of @a kFrameSize frames.
+   Done in segments of constant or linearly changing gain, which @a kGraceEnds splits where the grace period runs out.
+   @a kGraceEnds must be set if the grace period runs out within this block, and can only be set then.
+ */
+template <uint32_t kFrameSize, bool kGraceEnds>
+static inline
+void applyMuteGateGain(float* const out, MuteGate& gate, const float scaling) noexcept
+{
+    BlockValueSmoother& mute(gate.value);
+    uint32_t& graceFrames(gate.graceFrames);
+
+    for (uint32_t i = 0; i < kFrameSize;)
+    {
+        // grace period runs out on this frame
+        if (kGraceEnds && graceFrames == 1)
+        {
+            graceFrames = 0;
+            mute.setTargetValue(0.f);
+        }
+
+        uint32_t segment = kFrameSize - i;
+
+        if (kGraceEnds && graceFrames != 0)
+            segment = std::min(segment, graceFrames - 1);
+
+        if (const uint32_t rampFrames = mute.getRampFrames())
+        {
+            segment = std::min(segment, rampFrames);
+
+            float start, increment;
+            mute.nextRamp(segment, start, increment);
+            applyGainRamp(out + i, segment, start * scaling, increment * scaling);
+        }
+        else
+        {
+            applyGain(out + i, segment, mute.getTargetValue() * scaling);
+        }
+
+        if (kGraceEnds && graceFrames != 0)
+            graceFrames -= segment;
+
+        i += segment;
+    }
+
+    if (! kGraceEnds && graceFrames != 0)
+        graceFrames -= kFrameSize;
+}
+
+/**
+   Run @a gate for a block of @a kFrameSize frames with voice activity @a vad, applying its gain times @a scaling.
+ */
+template <uint32_t kFrameSize>
+static inline
+void processMuteGate(float* const out, MuteGate& gate, const float vad, const float threshold,
+                     const uint32_t gracePeriodInFrames, const float scaling) noexcept
+{
+    // unmute according to threshold
+    if (vad >= threshold)
+    {
+        gate.value.setTargetValue(1.f);
+        gate.graceFrames = gracePeriodInFrames;
+    }
+    else if (gracePeriodInFrames == 0)
+    {
+        gate.value.setTargetValue(0.f);
+    }
+
+    if (gate.graceFrames != 0 && gate.graceFrames <= kFrameSize)
+        applyMuteGateGain<kFrameSize, true>(out, gate, scaling);
+    else
+        applyMuteGateGain<kFrameSize, false>(out, gate, scaling);
+}
+
+/**
+   Same as processMuteGate for a gate known to stay open, which is the case for settled open gates at threshold 0.
+ */
+template <uint32_t kFrameSize>
+static inline
+void processOpenMuteGate(float* const out, MuteGate& gate, const uint32_t gracePeriodInFrames, const float scaling) noexcept
+{
+    gate.graceFrames = gracePeriodInFrames != 0 ? gracePeriodInFrames - kFrameSize : 0;
+
+    applyGain(out, kFrameSize, scaling);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -5,10 +5,29 @@
  */
 
 #include "DistrhoPlugin.hpp"
-#include "extra/RingBuffer.hpp"
-#include "extra/ValueSmoother.hpp"
+#include "extra/Thread.hpp"
+
+#include "AudioRingBuffer.hpp"
+#include "AutoTune.hpp"
+#include "CpuGovernor.hpp"
+#include "DspTiming.hpp"
+#include "GainRamp.hpp"
+#include "Int16Convert.hpp"
+#include "MuteGate.hpp"
+#include "RNNoiseArch.hpp"
+#include "RNNoiseLittle.h"
+#include "SharedModel.hpp"
+#include "SlidingStats.hpp"
+#include "SpscQueue.hpp"
+#include "VisualizationChannel.hpp"
 
 #include "rnnoise.h"
+#include "speex/speex_resampler.h"
+
+#ifdef RENOOICE_ECHO_CANCEL
+#include "speex/speex_echo.h"
+#include "speex/speex_preprocess.h"
+#endif
 
 START_NAMESPACE_DISTRHO
 
@@ -16,90 +35,276 @@ START_NAMESPACE_DISTRHO
 
 class ReNooicePlugin : public Plugin
 {
+    // plugin version, also part of the auto-tuning cache key
+    static constexpr const uint32_t kVersion = d_version(1, 0, 0);
+
     // scaling used for denoise processing
     static constexpr const uint32_t kDenoiseScaling = std::numeric_limits<short>::max();
     static constexpr const float kDenoiseScalingInv = 1.f / kDenoiseScaling;
 
-    // denoise block size
-    const uint32_t denoiseFrameSize = static_cast<uint32_t>(rnnoise_get_frame_size());
-    const uint32_t denoiseFrameSizeF = denoiseFrameSize * sizeof(float);
-
-    // denoise handle, keep it const so we never modify it
-    DenoiseState* const denoise = rnnoise_create(nullptr);
-
-    // buffers for latent processing
+    // sample rate that RNNoise was trained for, we resample to it if host runs at something else
+    static constexpr const uint32_t kDenoiseSampleRate = 48000;
+
+    // speex resampler quality for the "High" setting, above this the cost keeps growing with no audible gain on voice
+    static constexpr const int kSpeexResamplerQualityHigh = 8;
+
+    // number of channels processed by this plugin variant, each with its own denoise state
+    static constexpr const uint32_t kNumChannels = DISTRHO_PLUGIN_NUM_OUTPUTS;
+
+    // number of channels taken from the host, including the far-end reference of the echo cancelling variant.
+    // the reference is buffered and resampled together with the processed channels, as the last one.
+    static constexpr const uint32_t kNumInputChannels = DISTRHO_PLUGIN_NUM_INPUTS;
+
+    // denoise block size, fixed at build time so all block loops have constant trip counts.
+    // RNNoise only reports it at runtime, which is checked against this in the constructor.
+    static constexpr const uint32_t kDenoiseFrameSize = 480;
+    static constexpr const uint32_t kDenoiseFrameSizeF = kDenoiseFrameSize * sizeof(float);
+
+    // how many blocks a newly loaded model runs in parallel with the old one before taking over
+    static constexpr const uint32_t kModelWarmupBlocks = 4;
+
+    // denoise handles for all channels, using either the builtin model or one loaded from a file.
+    // builtin models come in pairs of regular and little model, linked through alternate,
+    // so that switching between them never needs to allocate.
+    struct DenoiseModel {
+        SharedModel* sharedModel;
+        DenoiseModel* alternate;
+        bool little;
+        DenoiseState* states[kNumChannels];
+    };
+
+    // model used for processing, only touched by the thread running denoise
+    DenoiseModel* modelActive = nullptr;
+
+    // model taking over from the active one, warming up and then crossfading
+    DenoiseModel* modelIncoming = nullptr;
+    uint32_t modelWarmupBlocksLeft = 0;
+
+    // hand-off from setState to processing, and back again once no longer in use
+    std::atomic<DenoiseModel*> modelPending { nullptr };
+    std::atomic<DenoiseModel*> modelRetired { nullptr };
+
+    // input below this level (in scaled units, so half of the smallest 16-bit step) is treated as silence
+    static constexpr const float kSilenceFloor = 0.5f;
+
+    // recent scaled input kept per channel while inference is skipped, a power of 2.
+    // these are all run through the network in the block that resumes, so its state matches continuous processing
+    // and no unprocessed input ever reaches the output. the CPU governor absorbs the extra inference of that block.
+    static constexpr const uint32_t kPrerollBlocks = 4;
+
+    // only touched by the thread running denoise
+    float* bufferPreroll;
+    uint32_t prerollPos[kNumChannels];
+    uint32_t prerollBlocksAvailable[kNumChannels];
+
+    // number of input blocks kept around, a power of 2 with room for the latency of the worker thread.
+    // the dry signal for smooth bypass is read back from these, so it needs no copying of its own.
+    static constexpr const uint32_t kNumInputBlocks = 4;
+
+    // buffers for latent processing, all planar (as required by RNNoise) with kDenoiseFrameSize frames per channel
+    // input blocks have kNumInputChannels channels, all others only the processed ones.
+    // input blocks are filled in turn, indexed by a free-running block counter masked to kNumInputBlocks.
+    // processed output of the previous block is given back to the host while the next input block fills up.
+    // there are 2 blocks of scaled input, so the previous one can still be pending while the current one is scaled.
     float* bufferIn;
+    float* bufferScaled;
     float* bufferOut;
-    HeapRingBuffer ringBufferDry;
-    HeapRingBuffer ringBufferOut;
+    float* bufferOutChannels[kNumChannels];
+    float* bufferModel;
+    uint32_t bufferInBlock;
     uint32_t bufferInPos;
 
-    // whether we received enough latent audio frames
-    bool processing;
+    // whether the previous block was taken directly from host input and still needs denoise,
+    // only happens when host cycles are aligned to denoise blocks
+    bool alignedBlockPending;
 
-   #ifndef SIMPLIFIED_NOOICE
-    // translate Grace Period param (ms) into 48kHz frames
+    // sample rate conversion to and from denoise rate, null when host runs at 48kHz
+    SpeexResamplerState* resamplerIn = nullptr;
+    SpeexResamplerState* resamplerOut = nullptr;
+    int resamplerQuality = -1;
+
+    // host-rate audio while resampling, denoised output and dry signal delayed by the full latency
+    AudioRingBuffer ringBufferOut;
+    AudioRingBuffer ringBufferDry;
+
+    // max frames per cycle while resampling, enough to fill a full denoise block
+    uint32_t bufferHostSize = 0;
+
+    // silence frames queued on the output side so resampled blocks always arrive in time
+    uint32_t resamplerPrimingFrames = 0;
+
+    // duration of a denoise block in host frames, rounded up
+    uint32_t denoiseBlockInHostFrames = 0;
+
+    // whether latency currently includes the extra worker thread block
+    bool workerLatency = false;
+
+    // total latency in host frames, as reported to the host
+    uint32_t latencyInFrames = 0;
+
+    // translate Grace Period param (ms) into frames at denoise rate
     // updated when param changes
     uint32_t gracePeriodInFrames = 0;
 
-    // assigned to gracePeriodInFrames when going mute
-    uint32_t numFramesUntilGracePeriodOver = 0;
-
     // smooth bypass
-    LinearValueSmoother dryValue;
+    BlockValueSmoother dryValue;
 
-    // smooth mute/unmute
-    LinearValueSmoother muteValue;
+    // voice activity gate, per channel
+    MuteGate muteGates[kNumChannels];
 
-    // cached parameter values
-    float parameters[kParamCount] = {};
+   #ifdef RENOOICE_ECHO_CANCEL
+    // default echo tail length, used when there are no parameters
+    static constexpr const float kEchoTailDefault = 100.f;
 
-    // denoise statistics
-    // mostly just for testing
-    struct {
-        float vads[200];
-        float avg, min, max;
-        int pos;
-        bool enabled = false;
-        bool running;
+    // echo canceller working on denoise blocks at 48kHz, with residual echo suppression (but no denoise) after it.
+    // created on activation, as tail length is only applied then
+    SpeexEchoState* echoState = nullptr;
+    SpeexPreprocessState* echoPreprocess = nullptr;
+
+    // 16-bit samples for the speex API, input and far-end reference of a block and echo cancelled output
+    int16_t echoIn[kDenoiseFrameSize];
+    int16_t echoRef[kDenoiseFrameSize];
+    int16_t echoOut[kDenoiseFrameSize];
+   #endif
+
+   #ifndef SIMPLIFIED_NOOICE
+    // optional worker thread for running denoise outside of the audio thread
+    // the audio thread hands over each full input block and picks up the previous one already denoised,
+    // which adds exactly one block of latency
+    class DenoiseWorker : public Thread
+    {
+    public:
+        struct Block {
+            uint32_t index;
+            bool skipSilence;
+            bool bypassed;
+            bool littleModel;
+            uint32_t skipped;
+           #if RENOOICE_DSP_TIMING
+            uint32_t processingTime;
+           #endif
+            float vads[kNumChannels];
+            float audio[kDenoiseFrameSize * kNumChannels];
+        };
+
+        // 4 blocks in flight is plenty, worker only needs to be 1 block ahead
+        SpscQueue<Block, 4> queueIn;
+        SpscQueue<Block, 4> queueOut;
+
+        DenoiseWorker(ReNooicePlugin& p, const int cpu)
+            : Thread("ReNooice worker"),
+              plugin(p),
+              cpuCore(cpu) {}
+
+        void wakeUp() noexcept
+        {
+            signal.signal();
+        }
 
-        void store(const float vad)
+        void stop()
         {
-            vads[pos++] = vad;
+            signalThreadShouldExit();
+            signal.signal();
+            stopThread(-1);
+        }
 
-            if (pos == ARRAY_SIZE(vads))
+    protected:
+        void run() override
+        {
+           #ifdef DISTRHO_OS_LINUX
+            if (cpuCore >= 0)
             {
-                pos = 0;
-                running = true;
+                cpu_set_t cpuset;
+                CPU_ZERO(&cpuset);
+                CPU_SET(cpuCore, &cpuset);
+                pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
             }
+           #endif
 
-            if (running)
+            while (! shouldThreadExit())
             {
-                avg = 0.f;
-                min = 1.f;
-                max = 0.f;
+                signal.wait();
 
-                for (uint32_t i = 0; i < ARRAY_SIZE(vads); ++i)
+                while (Block* const in = queueIn.getReadSlot())
                 {
-                    if (vads[i] < min)
-                        min = vads[i];
-                    if (vads[i] > max)
-                        max = vads[i];
+                    // results are not being picked up, try again on next wake up
+                    Block* const out = queueOut.getWriteSlot();
+                    if (out == nullptr)
+                        break;
 
-                    avg += vads[i];
-                }
+                    float* channels[kNumChannels];
+
+                    for (uint32_t c = 0; c < kNumChannels; ++c)
+                        channels[c] = out->audio + c * kDenoiseFrameSize;
 
-                avg /= ARRAY_SIZE(vads);
+                   #if RENOOICE_DSP_TIMING
+                    const uint64_t timeStart = getMonotonicTimeNs();
+                   #endif
+
+                    out->index = in->index;
+                    out->skipped = plugin.runDenoise(channels, in->audio, out->vads,
+                                                     in->skipSilence, in->bypassed, in->littleModel);
+
+                   #if RENOOICE_DSP_TIMING
+                    out->processingTime = static_cast<uint32_t>(getMonotonicTimeNs() - timeStart);
+                   #endif
+
+                    queueIn.commitRead();
+                    queueOut.commitWrite();
+                }
             }
         }
 
+    private:
+        ReNooicePlugin& plugin;
+        const int cpuCore;
+        Signal signal;
+    };
+
+    // null when running denoise on the audio thread
+    DenoiseWorker* worker = nullptr;
+
+    // index of the next denoise block, for matching worker results to what the audio thread expects
+    uint32_t workerBlockIndex = 0;
+
+    // denoise blocks processed output needs after skipping inference while bypassed, to cover the full latency
+    uint32_t bypassWarmupBlocks = 0;
+
+    // blocks left until processed output is valid again, bypass is kept engaged until then
+    uint32_t wetWarmupBlocks = 0;
+
+    // total RNNoise frames skipped, counted per channel
+    uint32_t skippedFrames = 0;
+
+    // cached parameter values
+    float parameters[kParamCount] = {};
+
+    // per-frame data for the UI, band energies only analyzed while the UI is reading
+    VisualizationChannel<kNumChannels> visualization;
+    BandEnergyAnalyzer<kNumChannels> analyzerIn;
+    BandEnergyAnalyzer<kNumChannels> analyzerOut;
+
+   #if RENOOICE_DSP_TIMING
+    // processing time of audio and worker threads, not yet split into denoise blocks
+    uint64_t timingPendingTime = 0;
+    uint32_t timingPendingFrames = 0;
+    BlockTimingStats timing;
+
+    // steps down to cheaper processing when over the cpu budget, fed from the same timing
+    CpuGovernor governor;
+   #endif
+
+    // denoise statistics, over short and long windows at the same time
+    // capacities are in denoise frames, with room for the longest window allowed by parameters
+    struct {
+        SlidingStats<256> shortWindow;
+        SlidingStats<8192> longWindow;
+        bool enabled = false;
+
         void reset()
         {
-            avg = 0.f;
-            min = 1.f;
-            max = 0.f;
-            pos = 0;
-            running = false;
+            shortWindow.reset();
+            longWindow.reset();
         }
     } stats;
    #endif
@@ -110,17 +315,43 @@ public:
       You must set all parameter values to their defaults, matching ParameterRanges::def.
     */
     ReNooicePlugin()
-        : Plugin(kParamCount, 0, 0) // parameters, programs, states
+        : Plugin(kParamCount, 0, kStateCount) // parameters, programs, states
     {
+        DISTRHO_SAFE_ASSERT(rnnoise_get_frame_size() == static_cast<int>(kDenoiseFrameSize));
+        DISTRHO_SAFE_ASSERT(rnnoise_little_get_frame_size() == static_cast<int>(kDenoiseFrameSize));
+
+        // picks the fastest RNNoise code path, only the very first time on a machine this takes a bit longer.
+        // dummy instances (host scans, ttl generation) never process audio, so they skip it.
+        if (! isDummyInstance())
+            applyRNNoiseAutoTune(kVersion);
+
+        modelActive = createDenoiseModel(nullptr);
+
        #ifndef SIMPLIFIED_NOOICE
         dryValue.setTimeConstant(0.02f);
         dryValue.setTargetValue(0.f);
 
-        muteValue.setTimeConstant(0.02f);
-        muteValue.setTargetValue(0.f);
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            muteGates[c].value.setTimeConstant(0.02f);
+            muteGates[c].value.setTargetValue(0.f);
+        }
 
         parameters[kParamThreshold] = 60.f;
+        parameters[kParamResampleQuality] = kResampleQualityVoIP;
+        parameters[kParamWorkerCPU] = -1.f;
+       #ifdef RENOOICE_ECHO_CANCEL
+        parameters[kParamEchoTail] = kEchoTailDefault;
+       #endif
+        parameters[kParamStatsShortWindow] = 250.f;
+        parameters[kParamStatsLongWindow] = 2.f;
         parameters[kParamMinimumVAD] = 100.f;
+        parameters[kParamShortMinimumVAD] = 100.f;
+       #endif
+
+       #if RENOOICE_DSP_TIMING
+        parameters[kParamGovernorBudget] = 50.f;
+        governor.setBudget(0.5);
        #endif
 
         // initial sample rate setup
@@ -132,7 +363,10 @@ public:
     */
     ~ReNooicePlugin()
     {
-        rnnoise_destroy(denoise);
+        destroyResamplers();
+
+        settleDenoiseModel();
+        destroyDenoiseModel(modelActive);
     }
 
 protected:
@@ -145,7 +379,7 @@ protected:
     */
     const char* getLabel() const noexcept override
     {
-        return "ReNooice";
+        return RENOOICE_LABEL;
     }
 
    /**
@@ -170,7 +404,7 @@ protected:
     */
     uint32_t getVersion() const noexcept override
     {
-        return d_version(1, 0, 0);
+        return kVersion;
     }
 
     // ----------------------------------------------------------------------------------------------------------------
@@ -182,7 +416,25 @@ protected:
     */
     void initAudioPort(bool input, uint32_t index, AudioPort& port) override
     {
-        port.groupId = kPortGroupMono;
+       #ifdef RENOOICE_ECHO_CANCEL
+        if (input && index == kNumChannels)
+        {
+            port.hints = kAudioPortIsSidechain;
+            port.name = "Far-End Reference";
+            port.symbol = "reference";
+            return;
+        }
+       #endif
+
+        switch (kNumChannels)
+        {
+        case 1:
+            port.groupId = kPortGroupMono;
+            break;
+        case 2:
+            port.groupId = kPortGroupStereo;
+            break;
+        }
 
         Plugin::initAudioPort(input, index, port);
     }
@@ -227,6 +479,125 @@ protected:
             parameter.ranges.min = 0.f;
             parameter.ranges.max = 1.f;
             break;
+        case kParamStatsShortWindow:
+            parameter.hints |= kParameterIsInteger;
+            parameter.name   = "Short Stats Window";
+            parameter.symbol = "stats_short_window";
+            parameter.unit   = "ms";
+            parameter.ranges.def = 250.f;
+            parameter.ranges.min = 10.f;
+            parameter.ranges.max = 2000.f;
+            break;
+        case kParamStatsLongWindow:
+            parameter.name   = "Long Stats Window";
+            parameter.symbol = "stats_long_window";
+            parameter.unit   = "s";
+            parameter.ranges.def = 2.f;
+            parameter.ranges.min = 0.5f;
+            parameter.ranges.max = 60.f;
+            break;
+        case kParamResampleQuality:
+            // resamplers are allocated on activation, so this cannot be automated
+            parameter.hints = kParameterIsInteger;
+            parameter.name   = "Resample Quality";
+            parameter.symbol = "resample_quality";
+            parameter.ranges.def = kResampleQualityVoIP;
+            parameter.ranges.min = kResampleQualityLowLatency;
+            parameter.ranges.max = kResampleQualityHigh;
+            parameter.enumValues.count = 4;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[4];
+                values[0].label = "Low Latency";
+                values[0].value = kResampleQualityLowLatency;
+                values[1].label = "VoIP";
+                values[1].value = kResampleQualityVoIP;
+                values[2].label = "Desktop";
+                values[2].value = kResampleQualityDesktop;
+                values[3].label = "High";
+                values[3].value = kResampleQualityHigh;
+                parameter.enumValues.values = values;
+            }
+            break;
+        case kParamWorkerThread:
+            // latency changes with this, so it is only applied on activation
+            parameter.hints = kParameterIsBoolean | kParameterIsInteger;
+            parameter.name   = "Worker Thread";
+            parameter.symbol = "worker_thread";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 1.f;
+            break;
+        case kParamWorkerCPU:
+            parameter.hints = kParameterIsInteger;
+            parameter.name   = "Worker CPU";
+            parameter.symbol = "worker_cpu";
+            parameter.ranges.def = -1.f;
+            parameter.ranges.min = -1.f;
+            parameter.ranges.max = 63.f;
+            parameter.enumValues.count = 1;
+            parameter.enumValues.restrictedMode = false;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[1];
+                values[0].label = "Any";
+                values[0].value = -1.f;
+                parameter.enumValues.values = values;
+            }
+            break;
+        case kParamSkipInference:
+            parameter.hints |= kParameterIsBoolean | kParameterIsInteger;
+            parameter.name   = "Skip Idle Inference";
+            parameter.symbol = "skip_inference";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 1.f;
+            break;
+        case kParamLittleModel:
+            parameter.hints |= kParameterIsBoolean | kParameterIsInteger;
+            parameter.name   = "Little Model";
+            parameter.symbol = "little_model";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 1.f;
+            break;
+       #ifdef RENOOICE_ECHO_CANCEL
+        case kParamEchoTail:
+            // echo canceller is created on activation, so this cannot be automated
+            parameter.hints = kParameterIsInteger;
+            parameter.name   = "Echo Tail";
+            parameter.symbol = "echo_tail";
+            parameter.unit   = "ms";
+            parameter.ranges.def = kEchoTailDefault;
+            parameter.ranges.min = 10.f;
+            parameter.ranges.max = 500.f;
+            break;
+       #endif
+       #if RENOOICE_DSP_TIMING
+        case kParamResetTiming:
+            parameter.hints |= kParameterIsTrigger;
+            parameter.name   = "Reset Timing";
+            parameter.symbol = "reset_timing";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 1.f;
+            break;
+        case kParamGovernor:
+            parameter.hints |= kParameterIsBoolean | kParameterIsInteger;
+            parameter.name   = "CPU Governor";
+            parameter.symbol = "governor";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 1.f;
+            break;
+        case kParamGovernorBudget:
+            parameter.name   = "CPU Budget";
+            parameter.symbol = "governor_budget";
+            parameter.unit   = "%";
+            parameter.ranges.def = 50.f;
+            parameter.ranges.min = 5.f;
+            parameter.ranges.max = 100.f;
+            break;
+       #endif
         case kParamCurrentVAD:
             parameter.hints |= kParameterIsOutput;
             parameter.name   = "Current VAD";
@@ -263,6 +634,107 @@ protected:
             parameter.ranges.min = 0.f;
             parameter.ranges.max = 100.f;
             break;
+        case kParamShortAverageVAD:
+            parameter.hints |= kParameterIsOutput;
+            parameter.name   = "Short Average VAD";
+            parameter.symbol = "short_avg_vad";
+            parameter.unit   = "%";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 100.f;
+            break;
+        case kParamShortMinimumVAD:
+            parameter.hints |= kParameterIsOutput;
+            parameter.name   = "Short Minimum VAD";
+            parameter.symbol = "short_min_vad";
+            parameter.unit   = "%";
+            parameter.ranges.def = 100.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 100.f;
+            break;
+        case kParamShortMaximumVAD:
+            parameter.hints |= kParameterIsOutput;
+            parameter.name   = "Short Maximum VAD";
+            parameter.symbol = "short_max_vad";
+            parameter.unit   = "%";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 100.f;
+            break;
+       #if RENOOICE_DSP_TIMING
+        case kParamCurrentLoad:
+            parameter.hints |= kParameterIsOutput;
+            parameter.name   = "Current Load";
+            parameter.symbol = "cur_load";
+            parameter.unit   = "%";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 100.f;
+            break;
+        case kParamAverageLoad:
+            parameter.hints |= kParameterIsOutput;
+            parameter.name   = "Average Load";
+            parameter.symbol = "avg_load";
+            parameter.unit   = "%";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 100.f;
+            break;
+        case kParamWorstLoad:
+            parameter.hints |= kParameterIsOutput;
+            parameter.name   = "Worst Load";
+            parameter.symbol = "worst_load";
+            parameter.unit   = "%";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 100.f;
+            break;
+        case kParamGovernorLevel:
+            parameter.hints |= kParameterIsOutput | kParameterIsInteger;
+            parameter.name   = "Governor Level";
+            parameter.symbol = "governor_level";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = kCpuGovernorLevelCount - 1;
+            parameter.enumValues.count = kCpuGovernorLevelCount;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[kCpuGovernorLevelCount];
+                values[0].label = "Full";
+                values[0].value = kCpuGovernorFull;
+                values[1].label = "Skip Idle Inference";
+                values[1].value = kCpuGovernorSkipIdle;
+                values[2].label = "Little Model";
+                values[2].value = kCpuGovernorLittleModel;
+                parameter.enumValues.values = values;
+            }
+            break;
+       #endif
+        case kParamDeadlineMisses:
+            parameter.hints |= kParameterIsOutput | kParameterIsInteger;
+            parameter.name   = "Deadline Misses";
+            parameter.symbol = "deadline_misses";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 16777216.f;
+            break;
+        case kParamSkippedFrames:
+            parameter.hints |= kParameterIsOutput | kParameterIsInteger;
+            parameter.name   = "Skipped Frames";
+            parameter.symbol = "skipped_frames";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 16777216.f;
+            break;
+        case kParamVisualization:
+            // id of the shared memory channel for the UI, not meant for hosts
+            parameter.hints |= kParameterIsOutput | kParameterIsInteger | kParameterIsHidden;
+            parameter.name   = "Visualization";
+            parameter.symbol = "visualization";
+            parameter.ranges.def = 0.f;
+            parameter.ranges.min = 0.f;
+            parameter.ranges.max = 16777215.f;
+            break;
         }
     }
 
@@ -287,17 +759,57 @@ protected:
 
         switch (index)
         {
-        case kParamBypass:
-            dryValue.setTargetValue(value);
-            break;
         case kParamGracePeriod:
-            // 48 frames = 1ms (48000 kHz [1s] / 1000)
-            gracePeriodInFrames = d_roundToUnsignedInt(value * 48.f);
+            // grace period is counted while processing denoise blocks, so always at 48kHz
+            gracePeriodInFrames = d_roundToUnsignedInt(value * (kDenoiseSampleRate / 1000));
+            break;
+       #if RENOOICE_DSP_TIMING
+        case kParamGovernor:
+            if (value < 0.5f)
+            {
+                governor.reset();
+                parameters[kParamGovernorLevel] = kCpuGovernorFull;
+            }
+            break;
+        case kParamGovernorBudget:
+            governor.setBudget(value * 0.01);
             break;
+       #endif
         }
     }
    #endif
 
+    // ----------------------------------------------------------------------------------------------------------------
+    // Internal data
+
+   /**
+      Initialize the state @a index.
+      This function will be called once, shortly after the plugin is created.
+    */
+    void initState(uint32_t index, State& state) override
+    {
+        switch (index)
+        {
+        case kStateModel:
+            state.hints = kStateIsFilenamePath;
+            state.key = "model";
+            state.defaultValue = "";
+            state.label = "Model";
+            state.description = "RNNoise weights file, the builtin model is used when empty";
+            break;
+        }
+    }
+
+   /**
+      Change an internal state @a key to @a value.
+      Loading happens right here, processing picks up the new model on its next denoise block.
+    */
+    void setState(const char* key, const char* value) override
+    {
+        if (std::strcmp(key, "model") == 0)
+            loadModel(value);
+    }
+
     // ----------------------------------------------------------------------------------------------------------------
     // Audio/MIDI Processing
 
@@ -306,27 +818,126 @@ protected:
     */
     void activate() override
     {
-        const uint32_t ringBufferSize = denoiseFrameSizeF * 2;
-        ringBufferDry.createBuffer(ringBufferSize);
-        ringBufferOut.createBuffer(ringBufferSize);
+        const double sampleRate = getSampleRate();
+
+       #ifndef SIMPLIFIED_NOOICE
+        // resample quality only changes on activation
+        const int quality = static_cast<int>(parameters[kParamResampleQuality] + 0.5f);
+       #else
+        const int quality = kResampleQualityVoIP;
+       #endif
+
+        if (quality != resamplerQuality)
+            setupResampling(sampleRate, quality);
+
+        // nothing is processing yet, so a model loaded in the meantime can take over right away
+        settleDenoiseModel();
+
+       #ifndef SIMPLIFIED_NOOICE
+        // same for switching between regular and little model
+        if (modelActive->alternate != nullptr && modelActive->little != (parameters[kParamLittleModel] > 0.5f))
+            modelActive = modelActive->alternate;
+
+        // shared memory for the UI is only created once there is something to show,
+        // so instances only queried for plugin info (ttl generation, host scans) leave nothing behind
+        if (! visualization.isValid())
+            parameters[kParamVisualization] = static_cast<float>(visualization.create());
+       #endif
+
+       #ifndef SIMPLIFIED_NOOICE
+        // worker thread also only changes on activation.
+        // it can only run in parallel with the audio thread if host blocks are not bigger than denoise blocks,
+        // otherwise a single host block would need more than 1 denoise block in advance.
+        const bool useWorker = parameters[kParamWorkerThread] > 0.5f
+                            && getBufferSize() <= denoiseBlockInHostFrames;
+       #else
+        const bool useWorker = false;
+       #endif
+
+        if (useWorker != workerLatency)
+        {
+            workerLatency = useWorker;
+            updateLatency();
+        }
+
+        if (resamplerIn != nullptr)
+        {
+            speex_resampler_reset_mem(resamplerIn);
+            speex_resampler_reset_mem(resamplerOut);
+
+            // dry signal needs to wait for the full latency, processed output only for the block-sized priming
+            const uint32_t ringBufferFrames = latencyInFrames + bufferHostSize * 2;
+            ringBufferOut.createBuffer(kNumChannels, ringBufferFrames);
+            ringBufferOut.commitWrite(resamplerPrimingFrames);
+            ringBufferDry.createBuffer(kNumChannels, ringBufferFrames);
+            ringBufferDry.commitWrite(latencyInFrames);
+        }
+
+       #ifdef RENOOICE_ECHO_CANCEL
+        createEchoCanceller();
+       #endif
 
-        bufferIn = new float[denoiseFrameSize];
-        bufferOut = new float[denoiseFrameSize];
+        // input blocks and processed output start out silent, which takes care of the initial latency
+        bufferIn = new float[kDenoiseFrameSize * kNumInputChannels * kNumInputBlocks]();
+        bufferScaled = new float[kDenoiseFrameSize * kNumChannels * 2];
+        bufferOut = new float[kDenoiseFrameSize * kNumChannels]();
+        bufferModel = new float[kDenoiseFrameSize * kNumChannels];
+        bufferPreroll = new float[kDenoiseFrameSize * kNumChannels * kPrerollBlocks];
+        bufferInBlock = 0;
         bufferInPos = 0;
-        processing = false;
+        alignedBlockPending = false;
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            bufferOutChannels[c] = bufferOut + c * kDenoiseFrameSize;
+            prerollPos[c] = 0;
+            prerollBlocksAvailable[c] = 0;
+        }
 
        #ifndef SIMPLIFIED_NOOICE
         parameters[kParamCurrentVAD] = 0.f;
         parameters[kParamAverageVAD] = 0.f;
         parameters[kParamMinimumVAD] = 100.f;
         parameters[kParamMaximumVAD] = 0.f;
+        parameters[kParamShortAverageVAD] = 0.f;
+        parameters[kParamShortMinimumVAD] = 100.f;
+        parameters[kParamShortMaximumVAD] = 0.f;
 
+        // everything in flight while processing at full latency, in denoise blocks
+        bypassWarmupBlocks = (latencyInFrames + denoiseBlockInHostFrames - 1) / denoiseBlockInHostFrames;
+        wetWarmupBlocks = 0;
+
+        dryValue.setTargetValue(parameters[kParamBypass] > 0.5f ? 1.f : 0.f);
         dryValue.clearToTargetValue();
 
-        muteValue.setTargetValue(0.f);
-        muteValue.clearToTargetValue();
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            muteGates[c].value.setTargetValue(0.f);
+            muteGates[c].value.clearToTargetValue();
+            muteGates[c].graceFrames = 0;
+        }
 
         stats.reset();
+
+        parameters[kParamDeadlineMisses] = 0.f;
+        parameters[kParamSkippedFrames] = 0.f;
+        skippedFrames = 0;
+
+       #if RENOOICE_DSP_TIMING
+        // budget is the duration of a denoise block
+        timing.setBudget(static_cast<uint64_t>(kDenoiseFrameSize) * 1000000000ULL / kDenoiseSampleRate);
+        resetTiming();
+
+        governor.reset();
+        parameters[kParamGovernorLevel] = kCpuGovernorFull;
+       #endif
+
+        if (useWorker)
+        {
+            workerBlockIndex = 0;
+            worker = new DenoiseWorker(*this, static_cast<int>(parameters[kParamWorkerCPU]));
+            worker->startThread(true);
+        }
        #endif
     }
 
@@ -335,11 +946,29 @@ protected:
     */
     void deactivate() override
     {
+       #ifndef SIMPLIFIED_NOOICE
+        if (worker != nullptr)
+        {
+            worker->stop();
+            delete worker;
+            worker = nullptr;
+        }
+       #endif
+
+        settleDenoiseModel();
+
         delete[] bufferIn;
+        delete[] bufferScaled;
         delete[] bufferOut;
+        delete[] bufferModel;
+        delete[] bufferPreroll;
 
-        ringBufferDry.deleteBuffer();
         ringBufferOut.deleteBuffer();
+        ringBufferDry.deleteBuffer();
+
+       #ifdef RENOOICE_ECHO_CANCEL
+        destroyEchoCanceller();
+       #endif
     }
 
    /**
@@ -348,8 +977,15 @@ protected:
     */
     void run(const float** const inputs, float** const outputs, const uint32_t frames) override
     {
-        const float* input = inputs[0];
-        /* */ float* output = outputs[0];
+       #if RENOOICE_DSP_TIMING
+        const uint64_t timeStart = getMonotonicTimeNs();
+
+        if (parameters[kParamResetTiming] > 0.5f)
+        {
+            parameters[kParamResetTiming] = 0.f;
+            resetTiming();
+        }
+       #endif
 
        #ifndef SIMPLIFIED_NOOICE
         // reset stats if enabled status changed
@@ -360,137 +996,138 @@ protected:
             stats.enabled = statsEnabled;
         }
 
-        // pass this threshold to unmute
-        const float threshold = parameters[kParamThreshold] * 0.01f;
+        // window lengths in denoise frames, only does real work when they change
+        const float denoiseFramesPerSecond = static_cast<float>(kDenoiseSampleRate) / kDenoiseFrameSize;
+        stats.shortWindow.setWindowSize(d_roundToUnsignedInt(parameters[kParamStatsShortWindow] * 0.001f * denoiseFramesPerSecond));
+        stats.longWindow.setWindowSize(d_roundToUnsignedInt(parameters[kParamStatsLongWindow] * denoiseFramesPerSecond));
+
+        // turning bypass off waits for processed output to be valid again, in case inference was skipped
+        dryValue.setTargetValue(parameters[kParamBypass] > 0.5f || wetWarmupBlocks != 0 ? 1.f : 0.f);
        #endif
 
         // process audio a few frames at a time, so it always fits nicely into denoise blocks
         for (uint32_t offset = 0; offset != frames;)
         {
-            const uint32_t framesCycle = std::min(denoiseFrameSize - bufferInPos, frames - offset);
-            const uint32_t framesCycleF = framesCycle * sizeof(float);
-
-            // copy input data into buffer
-            std::memcpy(bufferIn + bufferInPos, input, framesCycleF);
+            // fast path for a full denoise block from host buffers
+            if (bufferInPos == 0 && frames - offset >= kDenoiseFrameSize && resamplerIn == nullptr && ! workerLatency)
+            {
+                processAlignedBlock(inputs, outputs, offset);
+                offset += kDenoiseFrameSize;
+                continue;
+            }
 
-            // run denoise once input buffer is full
-            if ((bufferInPos += framesCycle) == denoiseFrameSize)
+            // back to the general path, finish what the fast path left behind
+            if (alignedBlockPending)
             {
-                bufferInPos = 0;
+                alignedBlockPending = false;
+                denoiseBlock(bufferOutChannels, getScaledBlock(bufferInBlock - 1));
+            }
 
-                // keep hold of dry signal so we can do smooth bypass
-                ringBufferDry.writeCustomData(bufferIn, denoiseFrameSizeF);
-                ringBufferDry.commitWrite();
-
-                // scale audio input for denoise
-                for (uint32_t i = 0; i < denoiseFrameSize; ++i)
-                    bufferIn[i] *= kDenoiseScaling;
-
-               #ifdef SIMPLIFIED_NOOICE
-                // run denoise
-                rnnoise_process_frame(denoise, bufferOut, bufferIn);
-
-                // scale back down to regular audio level
-                for (uint32_t i = 0; i < denoiseFrameSize; ++i)
-                    bufferOut[i] *= kDenoiseScalingInv;
-               #else
-                // run denoise
-                const float vad = rnnoise_process_frame(denoise, bufferOut, bufferIn);
-
-                // unmute according to threshold
-                if (vad >= threshold)
-                {
-                    muteValue.setTargetValue(1.f);
-                    numFramesUntilGracePeriodOver = gracePeriodInFrames;
-                }
-                else if (gracePeriodInFrames == 0)
+            float* const blockIn = getInputBlock(bufferInBlock);
+            uint32_t framesCycle;
+
+            // audio given back to host on this cycle, per channel
+            const float* wet[kNumChannels];
+            const float* dry[kNumChannels];
+
+            if (resamplerIn != nullptr)
+            {
+                // convert as many host frames as needed to fill the current denoise block,
+                // but stop at the end of the ring buffers so audio can always be accessed in place.
+                // all channels share the same resampler state, so they always consume and produce the same
+                const uint32_t framesMax = std::min(std::min(frames - offset, bufferHostSize),
+                                                    std::min(ringBufferOut.getContiguousReadFrames(),
+                                                             std::min(ringBufferDry.getContiguousReadFrames(),
+                                                                      ringBufferDry.getContiguousWriteFrames())));
+                uint32_t framesIn, framesOut;
+
+                for (uint32_t c = 0; c < kNumInputChannels; ++c)
                 {
-                    muteValue.setTargetValue(0.f);
+                    framesIn = framesMax;
+                    framesOut = kDenoiseFrameSize - bufferInPos;
+                    speex_resampler_process_float(resamplerIn, c,
+                                                  inputs[c] + offset, &framesIn,
+                                                  blockIn + c * kDenoiseFrameSize + bufferInPos, &framesOut);
                 }
 
-                // scale back down to regular audio level, also apply mute as needed
-                for (uint32_t i = 0; i < denoiseFrameSize; ++i)
+                // resampler is stuck, give silence for the rest of the cycle instead of leaving host memory as-is
+                if (framesIn == 0 && framesOut == 0)
                 {
-                    if (numFramesUntilGracePeriodOver != 0 && --numFramesUntilGracePeriodOver == 0)
-                        muteValue.setTargetValue(0.f);
+                    d_safe_assert("framesIn != 0 || framesOut != 0", __FILE__, __LINE__);
 
-                    bufferOut[i] *= kDenoiseScalingInv;
-                    bufferOut[i] *= muteValue.next();
+                    for (uint32_t c = 0; c < kNumChannels; ++c)
+                        std::memset(outputs[c] + offset, 0, (frames - offset) * sizeof(float));
+                    break;
                 }
 
-                // stats are a bit expensive, so they are optional
-                if (stats.enabled)
-                {
-                    stats.store(vad);
-                    parameters[kParamCurrentVAD] = vad * 100.f;
-                    parameters[kParamAverageVAD] = stats.avg * 100.f;
-                    parameters[kParamMinimumVAD] = stats.min * 100.f;
-                    parameters[kParamMaximumVAD] = stats.max * 100.f;
-                }
-               #endif
+                framesCycle = framesIn;
+                bufferInPos += framesOut;
 
-                // write denoise output into ringbuffer
-                ringBufferOut.writeCustomData(bufferOut, denoiseFrameSizeF);
-                ringBufferOut.commitWrite();
-            }
+                // processed output goes through the ring buffer, so this block is ready for the host right away
+                if (bufferInPos == kDenoiseFrameSize)
+                    processInputBlock(blockIn);
 
-            // we have enough audio frames in the ring buffer, can give back audio to host
-            if (processing)
-            {
-               #ifndef SIMPLIFIED_NOOICE
-                // apply smooth bypass
-                if (d_isNotEqual(dryValue.getCurrentValue(), dryValue.getTargetValue()))
+                // resampler can produce frames without consuming any
+                if (framesCycle == 0)
+                    continue;
+
+                // keep hold of dry signal so we can do smooth bypass
+                for (uint32_t c = 0; c < kNumChannels; ++c)
                 {
-                    // copy processed buffer directly into output
-                    ringBufferOut.readCustomData(output, framesCycleF);
-
-                    // retrieve dry buffer
-                    ringBufferDry.readCustomData(bufferOut, framesCycleF);
-
-                    for (uint32_t i = 0; i < framesCycle; ++i)
-                    {
-                        const float dry = dryValue.next();
-                        const float wet = 1.f - dry;
-                        output[i] = output[i] * wet + bufferOut[i] * dry;
-                    }
+                    std::memcpy(ringBufferDry.getWritePointer(c), inputs[c] + offset, framesCycle * sizeof(float));
+                    wet[c] = ringBufferOut.getReadPointer(c);
+                    dry[c] = ringBufferDry.getReadPointer(c);
                 }
-                // disable (bypass on)
-                else if (d_isNotZero(dryValue.getTargetValue()))
-                {
-                    // copy dry buffer directly into output
-                    ringBufferDry.readCustomData(output, framesCycleF);
 
-                    // retrieve processed buffer (doing nothing with it)
-                    ringBufferOut.readCustomData(bufferOut, framesCycleF);
-                }
-                // enabled (bypass off)
-                else
-               #endif
-                {
-                    // copy processed buffer directly into output
-                    ringBufferOut.readCustomData(output, framesCycleF);
+                ringBufferDry.commitWrite(framesCycle);
 
-                    // retrieve dry buffer (doing nothing with it)
-                    ringBufferDry.readCustomData(bufferOut, framesCycleF);
-                }
+                writeOutput(outputs, offset, wet, dry, framesCycle);
+
+                ringBufferOut.commitRead(framesCycle);
+                ringBufferDry.commitRead(framesCycle);
             }
-            // capture more audio frames until it fits 1 denoise block
             else
             {
-                // mute output while still capturing audio frames
-                std::memset(output, 0, framesCycleF);
+                framesCycle = std::min(kDenoiseFrameSize - bufferInPos, frames - offset);
 
-                if (ringBufferOut.getReadableDataSize() >= denoiseFrameSizeF)
-                    processing = true;
-            }
+                // dry signal is the input block from as many blocks ago as processing takes
+                const float* const blockDry = getInputBlock(bufferInBlock - (workerLatency ? 2 : 1));
 
-            offset += framesCycle;
-            input += framesCycle;
-            output += framesCycle;
-        }
-    }
+                // copy input data into current block, before output can overwrite it
+                for (uint32_t c = 0; c < kNumChannels; ++c)
+                {
+                    std::memcpy(blockIn + c * kDenoiseFrameSize + bufferInPos,
+                                inputs[c] + offset,
+                                framesCycle * sizeof(float));
 
-   /**
+                    wet[c] = bufferOut + c * kDenoiseFrameSize + bufferInPos;
+                    dry[c] = blockDry + c * kDenoiseFrameSize + bufferInPos;
+                }
+
+                // far-end reference, only needed as input
+                for (uint32_t c = kNumChannels; c < kNumInputChannels; ++c)
+                    std::memcpy(blockIn + c * kDenoiseFrameSize + bufferInPos,
+                                inputs[c] + offset,
+                                framesCycle * sizeof(float));
+
+                // previous block is given back while the current one fills up, so this needs to happen first
+                writeOutput(outputs, offset, wet, dry, framesCycle);
+
+                bufferInPos += framesCycle;
+
+                if (bufferInPos == kDenoiseFrameSize)
+                    processInputBlock(blockIn);
+            }
+
+            offset += framesCycle;
+        }
+
+       #if RENOOICE_DSP_TIMING
+        addProcessingTime(getMonotonicTimeNs() - timeStart, frames);
+       #endif
+    }
+
+   /**
       Optional callback to inform the plugin about a sample rate change.
       This function will only be called when the plugin is deactivated.
     */
@@ -498,11 +1135,878 @@ protected:
     {
        #ifndef SIMPLIFIED_NOOICE
         dryValue.setSampleRate(sampleRate);
-        muteValue.setSampleRate(sampleRate);
+
+        // mute is applied while processing denoise blocks
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+            muteGates[c].value.setSampleRate(kDenoiseSampleRate);
+
+        const int quality = static_cast<int>(parameters[kParamResampleQuality] + 0.5f);
+       #else
+        const int quality = kResampleQualityVoIP;
        #endif
-        setLatency(d_roundToUnsignedInt(sampleRate / 48000.0 * denoiseFrameSize));
+
+        setupResampling(sampleRate, quality);
     }
 
+    // ----------------------------------------------------------------------------------------------------------------
+    // Internal processing
+
+   /**
+      Process a full input block from @a blockIn, moving on to the next one.
+      When resampling, processed output is converted back to host rate and queued for the host.
+    */
+    void processInputBlock(const float* const blockIn)
+    {
+        bufferInPos = 0;
+        ++bufferInBlock;
+
+        bool blockReady = true;
+
+       #ifndef SIMPLIFIED_NOOICE
+        if (worker != nullptr)
+            blockReady = exchangeWorkerBlock(blockIn);
+        else
+       #endif
+            processDenoiseBlock(blockIn);
+
+        // no output until the worker had the chance to process the first block
+        if (! blockReady || resamplerOut == nullptr)
+            return;
+
+        // resample straight into the ring buffer, in as many pieces as needed to wrap around
+        for (uint32_t pos = 0; pos != kDenoiseFrameSize;)
+        {
+            uint32_t framesIn, framesOut;
+
+            for (uint32_t c = 0; c < kNumChannels; ++c)
+            {
+                framesIn = kDenoiseFrameSize - pos;
+                framesOut = ringBufferOut.getContiguousWriteFrames();
+                speex_resampler_process_float(resamplerOut, c,
+                                              bufferOut + c * kDenoiseFrameSize + pos, &framesIn,
+                                              ringBufferOut.getWritePointer(c), &framesOut);
+            }
+
+            // resampler is stuck, queue silence for the rest of the block so the host never reads stale audio
+            if (framesIn == 0 && framesOut == 0)
+            {
+                d_safe_assert("framesIn != 0 || framesOut != 0", __FILE__, __LINE__);
+                ringBufferOut.writeSilence(d_roundToUnsignedInt((kDenoiseFrameSize - pos) * getSampleRate()
+                                                                / kDenoiseSampleRate));
+                break;
+            }
+
+            ringBufferOut.commitWrite(framesOut);
+            pos += framesIn;
+        }
+    }
+
+   /**
+      Give back @a frames of audio to the host, from the @a wet and @a dry signal of each channel.
+      Dry signal is only looked at while bypass is engaged or changing.
+    */
+    void writeOutput(float** const outputs, const uint32_t offset,
+                     const float* const wet[kNumChannels], const float* const dry[kNumChannels], const uint32_t frames)
+    {
+       #ifndef SIMPLIFIED_NOOICE
+        // smooth bypass in progress
+        if (dryValue.getRampFrames() != 0)
+            writeOutputKernel<true>(outputs, offset, wet, dry, frames);
+
+        // disable (bypass on) or enable (bypass off)
+        else
+            writeOutputKernel<false>(outputs, offset, d_isNotZero(dryValue.getTargetValue()) ? dry : wet, dry, frames);
+       #else
+        writeOutputKernel<false>(outputs, offset, wet, dry, frames);
+       #endif
+    }
+
+   /**
+      Output kernel for writeOutput, with @a kBypassRamp set while smooth bypass is in progress.
+      Without it only @a wet is used, which the caller points to the dry signal while bypassed.
+    */
+    template <bool kBypassRamp>
+    void writeOutputKernel(float** const outputs, const uint32_t offset,
+                           const float* const wet[kNumChannels], const float* const dry[kNumChannels],
+                           const uint32_t frames)
+    {
+        uint32_t framesRamp = 0;
+        const float* const* source = wet;
+
+        if (kBypassRamp)
+        {
+            framesRamp = std::min(frames, dryValue.getRampFrames());
+
+            float start, increment;
+            dryValue.nextRamp(framesRamp, start, increment);
+
+            for (uint32_t c = 0; c < kNumChannels; ++c)
+                mixWithGainRamp(outputs[c] + offset, wet[c], dry[c], framesRamp, start, increment);
+
+            if (framesRamp == frames)
+                return;
+
+            source = d_isNotZero(dryValue.getTargetValue()) ? dry : wet;
+        }
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            float* const out = outputs[c] + offset;
+
+            // processed audio might already be in place
+            if (out != source[c])
+                std::memcpy(out + framesRamp, source[c] + framesRamp, (frames - framesRamp) * sizeof(float));
+        }
+    }
+
+    float* getInputBlock(const uint32_t block) const noexcept
+    {
+        return bufferIn + (block & (kNumInputBlocks - 1)) * kDenoiseFrameSize * kNumInputChannels;
+    }
+
+    float* getScaledBlock(const uint32_t block) const noexcept
+    {
+        return bufferScaled + (block & 1) * kDenoiseFrameSize * kNumChannels;
+    }
+
+   /**
+      Denoise all channels from planar @a in into @a out channels, storing each channel VAD in @a vads.
+      @a in must be already scaled for denoise.
+      Inference is skipped for silent channels if @a skipSilence is set, or for all channels if @a bypassed is set.
+      @a little selects the little builtin model, switched to with the same warmup and crossfade as a new model.
+      Returns the number of skipped channels, which get silence as output.
+      This is the expensive part of processing, called from the worker thread when enabled.
+    */
+    uint32_t runDenoise(float* const out[kNumChannels], const float* const in, float vads[kNumChannels],
+                        const bool skipSilence, const bool bypassed, const bool little)
+    {
+        // pick up a newly loaded model, as long as the one it replaced last time has been cleaned up
+        if (modelIncoming == nullptr && modelRetired.load(std::memory_order_acquire) == nullptr)
+        {
+            modelIncoming = modelPending.exchange(nullptr, std::memory_order_acquire);
+            modelWarmupBlocksLeft = kModelWarmupBlocks;
+
+            if (modelIncoming != nullptr && modelIncoming->alternate != nullptr && modelIncoming->little != little)
+                modelIncoming = modelIncoming->alternate;
+        }
+
+        // switch between builtin models, the other one of the pair is always allocated and ready
+        if (modelIncoming == nullptr && modelActive->alternate != nullptr && modelActive->little != little)
+        {
+            modelIncoming = modelActive->alternate;
+            modelWarmupBlocksLeft = kModelWarmupBlocks;
+        }
+
+        float vadsIncoming[kNumChannels];
+        uint32_t skipped = 0;
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            const float* const inc = in + c * kDenoiseFrameSize;
+
+            if (bypassed || (skipSilence && isBelowSilenceFloor(inc)))
+            {
+                // keep recent input around for when inference resumes
+                pushPrerollBlock(c, inc);
+
+                std::memset(out[c], 0, kDenoiseFrameSizeF);
+                std::memset(bufferModel + c * kDenoiseFrameSize, 0, kDenoiseFrameSizeF);
+                vads[c] = vadsIncoming[c] = 0.f;
+                ++skipped;
+                continue;
+            }
+
+            // resume from skipped inference by running the network through recent input first, discarding output
+            for (; prerollBlocksAvailable[c] != 0; --prerollBlocksAvailable[c])
+            {
+                const uint32_t block = (prerollPos[c] - prerollBlocksAvailable[c]) & (kPrerollBlocks - 1);
+                const float* const preroll = bufferPreroll + (c * kPrerollBlocks + block) * kDenoiseFrameSize;
+
+                processDenoiseFrame(modelActive, c, out[c], preroll);
+
+                if (modelIncoming != nullptr)
+                    processDenoiseFrame(modelIncoming, c, bufferModel + c * kDenoiseFrameSize, preroll);
+            }
+
+            // run denoise
+            vads[c] = processDenoiseFrame(modelActive, c, out[c], inc);
+
+            // run new model in parallel until its recurrent state settles
+            if (modelIncoming != nullptr)
+                vadsIncoming[c] = processDenoiseFrame(modelIncoming, c, bufferModel + c * kDenoiseFrameSize, inc);
+        }
+
+        if (modelIncoming == nullptr || --modelWarmupBlocksLeft != 0)
+            return skipped;
+
+        // crossfade into the new model over this block, then swap
+        const float step = 1.f / kDenoiseFrameSize;
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            float* const o = out[c];
+            const float* const n = bufferModel + c * kDenoiseFrameSize;
+
+            for (uint32_t i = 0; i < kDenoiseFrameSize; ++i)
+                o[i] += (n[i] - o[i]) * (step * (i + 1));
+
+            vads[c] = vadsIncoming[c];
+        }
+
+        // the other model of a builtin pair stays around for switching back
+        if (modelActive->alternate != modelIncoming)
+            modelRetired.store(modelActive, std::memory_order_release);
+
+        modelActive = modelIncoming;
+        modelIncoming = nullptr;
+        return skipped;
+    }
+
+   /**
+      Append a block of scaled input to the pre-roll of channel @a c.
+    */
+    void pushPrerollBlock(const uint32_t c, const float* const in) noexcept
+    {
+        const uint32_t block = prerollPos[c]++ & (kPrerollBlocks - 1);
+
+        std::memcpy(bufferPreroll + (c * kPrerollBlocks + block) * kDenoiseFrameSize, in, kDenoiseFrameSizeF);
+
+        if (prerollBlocksAvailable[c] != kPrerollBlocks)
+            ++prerollBlocksAvailable[c];
+    }
+
+    static float processDenoiseFrame(DenoiseModel* const model, const uint32_t c, float* const out, const float* const in)
+    {
+        return model->little ? rnnoise_little_process_frame(model->states[c], out, in)
+                             : rnnoise_process_frame(model->states[c], out, in);
+    }
+
+    bool isBelowSilenceFloor(const float* const in) const noexcept
+    {
+        float peak = 0.f;
+
+        for (uint32_t i = 0; i < kDenoiseFrameSize; ++i)
+            peak = std::max(peak, std::abs(in[i]));
+
+        return peak < kSilenceFloor;
+    }
+
+   /**
+      Scale denoised @a out channels back down to regular audio level, applying mute as needed.
+      Picks the gate kernel once per block, a gate that cannot close only needs the scaling.
+    */
+    void applyDenoiseGain(float* const out[kNumChannels], const float vads[kNumChannels])
+    {
+       #ifdef SIMPLIFIED_NOOICE
+        // there is no mute gate
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+            processOpenMuteGate<kDenoiseFrameSize>(out[c], muteGates[c], gracePeriodInFrames, kDenoiseScalingInv);
+
+        // unused
+        (void)vads;
+       #else
+        // pass this threshold to unmute
+        const float threshold = parameters[kParamThreshold] * 0.01f;
+
+        bool gateCanClose = threshold > 0.f;
+        for (uint32_t c = 0; c < kNumChannels && ! gateCanClose; ++c)
+            gateCanClose = ! muteGates[c].isSettledOpen<kDenoiseFrameSize>(gracePeriodInFrames);
+
+        // highest voice activity among all channels, used for stats
+        float vadMax = 0.f;
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+            vadMax = std::max(vadMax, vads[c]);
+
+        if (gateCanClose)
+        {
+            for (uint32_t c = 0; c < kNumChannels; ++c)
+                processMuteGate<kDenoiseFrameSize>(out[c], muteGates[c], vads[c], threshold,
+                                                   gracePeriodInFrames, kDenoiseScalingInv);
+        }
+        else
+        {
+            for (uint32_t c = 0; c < kNumChannels; ++c)
+                processOpenMuteGate<kDenoiseFrameSize>(out[c], muteGates[c], gracePeriodInFrames, kDenoiseScalingInv);
+        }
+
+        if (stats.enabled)
+        {
+            stats.shortWindow.store(vadMax);
+            stats.longWindow.store(vadMax);
+            parameters[kParamCurrentVAD] = vadMax * 100.f;
+            parameters[kParamAverageVAD] = stats.longWindow.getAverage() * 100.f;
+            parameters[kParamMinimumVAD] = stats.longWindow.getMinimum() * 100.f;
+            parameters[kParamMaximumVAD] = stats.longWindow.getMaximum() * 100.f;
+            parameters[kParamShortAverageVAD] = stats.shortWindow.getAverage() * 100.f;
+            parameters[kParamShortMinimumVAD] = stats.shortWindow.getMinimum() * 100.f;
+            parameters[kParamShortMaximumVAD] = stats.shortWindow.getMaximum() * 100.f;
+        }
+
+        if (visualization.isValid())
+            publishVisualization(out, vads);
+       #endif
+    }
+
+   #ifndef SIMPLIFIED_NOOICE
+   /**
+      Send the denoise frame just finished in @a out to the UI, together with its input and @a vads.
+      Must be called right after applying gain to @a out.
+    */
+    void publishVisualization(const float* const out[kNumChannels], const float vads[kNumChannels])
+    {
+        VisualizationFrame<kNumChannels>* const frame = visualization.getWriteFrame();
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            frame->vads[c] = vads[c];
+            frame->muteGains[c] = muteGates[c].value.getCurrentValue();
+        }
+
+        std::memset(frame->inputEnergy, 0, sizeof(frame->inputEnergy));
+        std::memset(frame->outputEnergy, 0, sizeof(frame->outputEnergy));
+
+        if (visualization.isReaderActive())
+        {
+            // unprocessed input of this frame, same as used for dry signal
+            const float* const blockIn = getInputBlock(bufferInBlock - (workerLatency ? 2 : 1));
+
+            for (uint32_t c = 0; c < kNumChannels; ++c)
+            {
+                analyzerIn.process(c, blockIn + c * kDenoiseFrameSize, kDenoiseFrameSize, frame->inputEnergy);
+                analyzerOut.process(c, out[c], kDenoiseFrameSize, frame->outputEnergy);
+            }
+        }
+
+        visualization.commitWrite();
+    }
+   #endif
+
+   /**
+      Denoise a block already scaled in @a scaled into @a out channels, at 48kHz.
+    */
+    void denoiseBlock(float* const out[kNumChannels], const float* const scaled)
+    {
+        float vads[kNumChannels];
+
+       #ifndef SIMPLIFIED_NOOICE
+        const bool skipSilence = useSkipInference();
+        const uint32_t skipped = runDenoise(out, scaled, vads, skipSilence, nextBlockBypassed(skipSilence),
+                                            useLittleModel());
+        addSkippedFrames(skipped);
+       #else
+        // no parameters to turn skipping on, so output stays the same as always
+        runDenoise(out, scaled, vads, false, false, false);
+       #endif
+
+        applyDenoiseGain(out, vads);
+    }
+
+   /**
+      Denoise a full input block from @a blockIn into @a bufferOut, at 48kHz.
+    */
+    void processDenoiseBlock(const float* const blockIn)
+    {
+        float* const scaled = getScaledBlock(bufferInBlock);
+
+        scaleInputBlock(scaled, blockIn);
+
+        denoiseBlock(bufferOutChannels, scaled);
+    }
+
+   /**
+      Scale a full input block from @a blockIn for denoise into @a scaled, input block is kept as-is for dry signal.
+      The echo cancelling variant cancels echo of the far-end reference in the same step,
+      its 16-bit output being in denoise units already.
+    */
+    void scaleInputBlock(float* const scaled, const float* const blockIn)
+    {
+       #ifdef RENOOICE_ECHO_CANCEL
+        convertFloatToInt16(echoIn, blockIn, kDenoiseFrameSize);
+        convertFloatToInt16(echoRef, blockIn + kNumChannels * kDenoiseFrameSize, kDenoiseFrameSize);
+
+        speex_echo_cancellation(echoState, echoIn, echoRef, echoOut);
+        speex_preprocess_run(echoPreprocess, echoOut);
+
+        convertInt16ToFloat(scaled, echoOut, kDenoiseFrameSize, 1.f);
+       #else
+        copyWithGain(scaled, blockIn, kDenoiseFrameSize * kNumChannels, kDenoiseScaling);
+       #endif
+    }
+
+   /**
+      Process a full denoise block straight from host buffers at @a offset, for host cycles aligned to denoise blocks.
+      The previous block is denoised directly into host output, the current one is only kept and scaled for next time.
+      Must only be called at the start of a block, when running at 48kHz without worker thread.
+    */
+    void processAlignedBlock(const float** const inputs, float** const outputs, const uint32_t offset)
+    {
+        float* const blockIn = getInputBlock(bufferInBlock);
+        float* const scaled = getScaledBlock(bufferInBlock);
+        const float* const blockDry = getInputBlock(bufferInBlock - 1);
+
+        float* out[kNumChannels];
+        const float* dry[kNumChannels];
+
+        // take input before output can overwrite it, keeping it as-is for dry signal
+        for (uint32_t c = 0; c < kNumInputChannels; ++c)
+            std::memcpy(blockIn + c * kDenoiseFrameSize, inputs[c] + offset, kDenoiseFrameSizeF);
+
+        scaleInputBlock(scaled, blockIn);
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            out[c] = outputs[c] + offset;
+            dry[c] = blockDry + c * kDenoiseFrameSize;
+        }
+
+        // previous block, either still to denoise or already processed by the general path
+        if (alignedBlockPending)
+        {
+            denoiseBlock(out, getScaledBlock(bufferInBlock - 1));
+            writeOutput(outputs, offset, out, dry, kDenoiseFrameSize);
+        }
+        else
+        {
+            writeOutput(outputs, offset, bufferOutChannels, dry, kDenoiseFrameSize);
+        }
+
+        alignedBlockPending = true;
+        ++bufferInBlock;
+    }
+
+   #ifndef SIMPLIFIED_NOOICE
+   /**
+      Hand over the input block in @a blockIn to the worker thread and retrieve the previous one into @a bufferOut.
+      Returns false for the very first block, as there is nothing to retrieve yet.
+      If the worker has not finished the previous block in time, its output is replaced by silence.
+    */
+    bool exchangeWorkerBlock(const float* const blockIn)
+    {
+        const uint32_t blockIndex = workerBlockIndex++;
+
+        // scaling, echo cancellation and bypass tracking happen for every block, even if the worker is behind,
+        // so echo canceller and mute gate keep following the audio. scaled blocks are otherwise unused with a worker.
+        float* const scaled = getScaledBlock(bufferInBlock);
+        scaleInputBlock(scaled, blockIn);
+
+        const bool skipSilence = useSkipInference();
+        const bool bypassed = nextBlockBypassed(skipSilence);
+
+        // a full queue drops the block, counted as a deadline miss once its result is due
+        if (DenoiseWorker::Block* const block = worker->queueIn.getWriteSlot())
+        {
+            std::memcpy(block->audio, scaled, kDenoiseFrameSizeF * kNumChannels);
+
+            block->index = blockIndex;
+            block->skipSilence = skipSilence;
+            block->bypassed = bypassed;
+            block->littleModel = useLittleModel();
+            worker->queueIn.commitWrite();
+        }
+
+        worker->wakeUp();
+
+        if (blockIndex == 0)
+            return false;
+
+        const uint32_t expectedIndex = blockIndex - 1;
+
+        while (DenoiseWorker::Block* const block = worker->queueOut.getReadSlot())
+        {
+            // late result, already replaced by silence
+            if (static_cast<int32_t>(block->index - expectedIndex) < 0)
+            {
+                worker->queueOut.commitRead();
+                continue;
+            }
+
+            if (block->index != expectedIndex)
+                break;
+
+            std::memcpy(bufferOut, block->audio, kDenoiseFrameSizeF * kNumChannels);
+
+            float vads[kNumChannels];
+            std::memcpy(vads, block->vads, sizeof(vads));
+            addSkippedFrames(block->skipped);
+           #if RENOOICE_DSP_TIMING
+            timingPendingTime += block->processingTime;
+           #endif
+
+            worker->queueOut.commitRead();
+
+            applyDenoiseGain(bufferOutChannels, vads);
+            return true;
+        }
+
+        // worker fell behind, the mute gate still runs so its hold time keeps counting in real time
+        std::memset(bufferOut, 0, kDenoiseFrameSizeF * kNumChannels);
+        parameters[kParamDeadlineMisses] += 1.f;
+
+        const float vads[kNumChannels] = {};
+        applyDenoiseGain(bufferOutChannels, vads);
+        return true;
+    }
+
+   /**
+      Check if inference can be skipped for the next denoise block because bypass is fully engaged.
+      Also keeps track of how long processed output needs to become valid again afterwards.
+    */
+    bool nextBlockBypassed(const bool skipInference) noexcept
+    {
+        const bool bypassed = skipInference
+                           && parameters[kParamBypass] > 0.5f
+                           && dryValue.getTargetValue() > 0.5f
+                           && dryValue.getRampFrames() == 0;
+
+        if (bypassed)
+            wetWarmupBlocks = bypassWarmupBlocks;
+        else if (wetWarmupBlocks != 0)
+            --wetWarmupBlocks;
+
+        return bypassed;
+    }
+
+    bool useSkipInference() const noexcept
+    {
+       #if RENOOICE_DSP_TIMING
+        if (governor.getLevel() >= kCpuGovernorSkipIdle)
+            return true;
+       #endif
+        return parameters[kParamSkipInference] > 0.5f;
+    }
+
+    bool useLittleModel() const noexcept
+    {
+       #if RENOOICE_DSP_TIMING
+        if (governor.getLevel() >= kCpuGovernorLittleModel)
+            return true;
+       #endif
+        return parameters[kParamLittleModel] > 0.5f;
+    }
+
+    void addSkippedFrames(const uint32_t frames) noexcept
+    {
+        if (frames == 0)
+            return;
+
+        skippedFrames += frames;
+        parameters[kParamSkippedFrames] = static_cast<float>(skippedFrames);
+    }
+   #endif
+
+   #if RENOOICE_DSP_TIMING
+   /**
+      Account for @a time nanoseconds spent processing @a frames host frames.
+      Time is split evenly into denoise blocks as they complete, worker thread time gets added as results come in.
+    */
+    void addProcessingTime(const uint64_t time, const uint32_t frames)
+    {
+        timingPendingTime += time;
+        timingPendingFrames += frames;
+
+        if (timingPendingFrames < denoiseBlockInHostFrames)
+            return;
+
+        const uint32_t numBlocks = timingPendingFrames / denoiseBlockInHostFrames;
+        const uint64_t blockTime = timingPendingTime * denoiseBlockInHostFrames / timingPendingFrames;
+
+        timing.store(blockTime, numBlocks);
+        timingPendingTime -= blockTime * numBlocks;
+        timingPendingFrames -= denoiseBlockInHostFrames * numBlocks;
+
+        parameters[kParamCurrentLoad] = timing.getCurrentLoad();
+        parameters[kParamAverageLoad] = timing.getAverageLoad();
+        parameters[kParamWorstLoad] = timing.getWorstLoad();
+
+        if (parameters[kParamGovernor] > 0.5f)
+        {
+            const double load = timing.getCurrentLoad() * 0.01;
+
+            for (uint32_t i = 0; i < numBlocks; ++i)
+                governor.process(load);
+
+            parameters[kParamGovernorLevel] = governor.getLevel();
+        }
+
+        if (visualization.isValid())
+            visualization.writeTimingHistogram(timing.getHistogram());
+    }
+
+    void resetTiming()
+    {
+        timing.reset();
+        timingPendingTime = 0;
+        timingPendingFrames = 0;
+
+        parameters[kParamCurrentLoad] = 0.f;
+        parameters[kParamAverageLoad] = 0.f;
+        parameters[kParamWorstLoad] = 0.f;
+
+        if (visualization.isValid())
+            visualization.writeTimingHistogram(timing.getHistogram());
+    }
+   #endif
+
+   /**
+      Load a model file, or the builtin model if @a filename is empty, and queue it for processing.
+      Must not be called from the audio thread.
+    */
+    void loadModel(const char* const filename)
+    {
+        // clean up the model swapped out by the previous load
+        destroyDenoiseModel(modelRetired.exchange(nullptr, std::memory_order_acquire));
+
+        // failures are already logged, the current model stays in use
+        DenoiseModel* const model = createDenoiseModel(filename);
+        if (model == nullptr)
+            return;
+
+        // replaces a previously loaded model that processing has not picked up yet
+        destroyDenoiseModel(modelPending.exchange(model, std::memory_order_acq_rel));
+    }
+
+   /**
+      Complete any pending model change immediately, used while not processing.
+    */
+    void settleDenoiseModel()
+    {
+        if (modelIncoming != nullptr)
+        {
+            if (modelActive->alternate != modelIncoming)
+                destroyDenoiseModel(modelActive);
+            modelActive = modelIncoming;
+            modelIncoming = nullptr;
+        }
+
+        if (DenoiseModel* const model = modelPending.exchange(nullptr, std::memory_order_acquire))
+        {
+            destroyDenoiseModel(modelActive);
+            modelActive = model;
+        }
+
+        destroyDenoiseModel(modelRetired.exchange(nullptr, std::memory_order_acquire));
+    }
+
+    static DenoiseModel* createDenoiseModel(const char* const filename)
+    {
+        SharedModel* sharedModel = nullptr;
+
+        if (filename != nullptr && filename[0] != '\0')
+        {
+            sharedModel = SharedModel::acquire(filename);
+            if (sharedModel == nullptr)
+                return nullptr;
+        }
+
+        DenoiseModel* const model = new DenoiseModel;
+        model->sharedModel = sharedModel;
+        model->alternate = nullptr;
+        model->little = false;
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+            model->states[c] = rnnoise_create(sharedModel != nullptr ? sharedModel->getModel() : nullptr);
+
+        // model files only have the regular layout, the little model is builtin only
+        if (sharedModel == nullptr)
+        {
+            DenoiseModel* const little = new DenoiseModel;
+            little->sharedModel = nullptr;
+            little->alternate = model;
+            little->little = true;
+            model->alternate = little;
+
+            for (uint32_t c = 0; c < kNumChannels; ++c)
+                little->states[c] = rnnoise_little_create(nullptr);
+        }
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            if (model->states[c] == nullptr || (model->alternate != nullptr && model->alternate->states[c] == nullptr))
+            {
+                d_stderr2("Invalid RNNoise model file '%s'", sharedModel != nullptr ? filename : "(builtin)");
+                destroyDenoiseModel(model);
+                return nullptr;
+            }
+        }
+
+        return model;
+    }
+
+    static void destroyDenoiseModel(DenoiseModel* const model)
+    {
+        if (model == nullptr)
+            return;
+
+        // both models of a builtin pair go together
+        if (DenoiseModel* const alternate = model->alternate)
+        {
+            alternate->alternate = nullptr;
+            destroyDenoiseModel(alternate);
+        }
+
+        for (uint32_t c = 0; c < kNumChannels; ++c)
+        {
+            if (model->states[c] == nullptr)
+                continue;
+
+            if (model->little)
+                rnnoise_little_destroy(model->states[c]);
+            else
+                rnnoise_destroy(model->states[c]);
+        }
+
+        if (model->sharedModel != nullptr)
+            SharedModel::release(model->sharedModel);
+
+        delete model;
+    }
+
+   /**
+      (Re)create the resamplers for @a sampleRate and update the reported latency.
+      Must not be called while the plugin is active.
+    */
+    void setupResampling(const double sampleRate, const int quality)
+    {
+        destroyResamplers();
+
+        resamplerQuality = quality;
+
+        const uint32_t hostRate = d_roundToUnsignedInt(sampleRate);
+
+        if (hostRate == kDenoiseSampleRate || hostRate == 0)
+        {
+            denoiseBlockInHostFrames = kDenoiseFrameSize;
+            bufferHostSize = 0;
+            updateLatency();
+            return;
+        }
+
+        const int speexQuality = getSpeexResamplerQuality(quality);
+        int errIn = RESAMPLER_ERR_SUCCESS;
+        int errOut = RESAMPLER_ERR_SUCCESS;
+
+        resamplerIn = speex_resampler_init(kNumInputChannels, hostRate, kDenoiseSampleRate, speexQuality, &errIn);
+        resamplerOut = speex_resampler_init(kNumChannels, kDenoiseSampleRate, hostRate, speexQuality, &errOut);
+
+        if (resamplerIn == nullptr || resamplerOut == nullptr
+            || errIn != RESAMPLER_ERR_SUCCESS || errOut != RESAMPLER_ERR_SUCCESS)
+        {
+            d_stderr2("Failed to create resamplers for %u Hz, audio will be processed at host rate", hostRate);
+            destroyResamplers();
+            denoiseBlockInHostFrames = kDenoiseFrameSize;
+            bufferHostSize = 0;
+            updateLatency();
+            return;
+        }
+
+        denoiseBlockInHostFrames = (kDenoiseFrameSize * hostRate + kDenoiseSampleRate - 1) / kDenoiseSampleRate;
+        bufferHostSize = denoiseBlockInHostFrames + 8;
+
+        updateLatency();
+    }
+
+   /**
+      Calculate and report latency based on current resampling and worker thread setup.
+    */
+    void updateLatency()
+    {
+        // worker thread gives back each block one block later
+        const uint32_t numBlocks = workerLatency ? 2 : 1;
+
+        if (resamplerIn != nullptr)
+        {
+            // resampled output comes in bursts of a denoise block, so we need that much silence queued in advance,
+            // plus 1 frame for the fractional position of the resamplers.
+            resamplerPrimingFrames = denoiseBlockInHostFrames * numBlocks + 1;
+
+            // filter delay of each resampler is given in host frames
+            latencyInFrames = resamplerPrimingFrames
+                            + static_cast<uint32_t>(speex_resampler_get_input_latency(resamplerIn))
+                            + static_cast<uint32_t>(speex_resampler_get_output_latency(resamplerOut));
+        }
+        else
+        {
+            resamplerPrimingFrames = 0;
+            latencyInFrames = kDenoiseFrameSize * numBlocks;
+        }
+
+        setLatency(latencyInFrames);
+    }
+
+    void destroyResamplers()
+    {
+        if (resamplerIn != nullptr)
+        {
+            speex_resampler_destroy(resamplerIn);
+            resamplerIn = nullptr;
+        }
+
+        if (resamplerOut != nullptr)
+        {
+            speex_resampler_destroy(resamplerOut);
+            resamplerOut = nullptr;
+        }
+    }
+
+    static int getSpeexResamplerQuality(const int quality) noexcept
+    {
+        switch (quality)
+        {
+        case kResampleQualityLowLatency:
+            return SPEEX_RESAMPLER_QUALITY_MIN;
+        case kResampleQualityDesktop:
+            return SPEEX_RESAMPLER_QUALITY_DESKTOP;
+        case kResampleQualityHigh:
+            return kSpeexResamplerQualityHigh;
+        default:
+            return SPEEX_RESAMPLER_QUALITY_VOIP;
+        }
+    }
+
+   #ifdef RENOOICE_ECHO_CANCEL
+   /**
+      Create the echo canceller for the current tail length, working on denoise blocks at 48kHz.
+      Must not be called while the plugin is active.
+    */
+    void createEchoCanceller()
+    {
+       #ifndef SIMPLIFIED_NOOICE
+        const float tail = parameters[kParamEchoTail];
+       #else
+        const float tail = kEchoTailDefault;
+       #endif
+
+        const int filterLength = static_cast<int>(d_roundToUnsignedInt(tail * (kDenoiseSampleRate / 1000)));
+
+        echoState = speex_echo_state_init(kDenoiseFrameSize, filterLength);
+        echoPreprocess = speex_preprocess_state_init(kDenoiseFrameSize, kDenoiseSampleRate);
+
+        int sampleRate = kDenoiseSampleRate;
+        speex_echo_ctl(echoState, SPEEX_ECHO_SET_SAMPLING_RATE, &sampleRate);
+        speex_preprocess_ctl(echoPreprocess, SPEEX_PREPROCESS_SET_ECHO_STATE, echoState);
+
+        // noise is taken care of by RNNoise
+        spx_int32_t off = 0;
+        speex_preprocess_ctl(echoPreprocess, SPEEX_PREPROCESS_SET_DENOISE, &off);
+    }
+
+    void destroyEchoCanceller()
+    {
+        if (echoPreprocess != nullptr)
+        {
+            speex_preprocess_state_destroy(echoPreprocess);
+            echoPreprocess = nullptr;
+        }
+
+        if (echoState != nullptr)
+        {
+            speex_echo_state_destroy(echoState);
+            echoState = nullptr;
+        }
+    }
+   #endif
+
     // ----------------------------------------------------------------------------------------------------------------
 
     DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReNooicePlugin)
@@ -524,3 +2028,11 @@ Plugin* createPlugin()
 // --------------------------------------------------------------------------------------------------------------------
 
 END_NAMESPACE_DISTRHO
+
+#ifdef RNN_ENABLE_X86_RTCD
+// called by rnnoise when creating a denoise state, replacing its own cpu detection so a code path can be forced
+extern "C" int rnn_select_arch(void)
+{
+    return DISTRHO_NAMESPACE::getRNNoiseArch();
+}
+#endif
@@ -7,6 +7,7 @@
 #include "DistrhoUI.hpp"
 
 #include "Layouts.hpp"
+#include "VisualizationView.hpp"
 
 START_NAMESPACE_DISTRHO
 
@@ -14,7 +15,8 @@ START_NAMESPACE_DISTRHO
 
 class ReNooiceUI : public UI,
                    public ButtonEventHandler::Callback,
-                   public KnobEventHandler::Callback
+                   public KnobEventHandler::Callback,
+                   public VisualizationView<RENOOICE_NUM_CHANNELS>::Callback
 {
     struct Theme : QuantumTheme {
         Theme(NanoTopLevelWidget* const parent)
@@ -52,6 +54,10 @@ class ReNooiceUI : public UI,
         QuantumValueMeterWithLabel statAverage;
         QuantumValueMeterWithLabel statMinimum;
         QuantumValueMeterWithLabel statMaximum;
+        QuantumVisualization<RENOOICE_NUM_CHANNELS> visualization;
+
+        // height needed to fit all widgets, updated on every layout change
+        uint minimumHeight = 0;
 
         Widgets(ReNooiceUI* const ui)
             : theme(ui),
@@ -68,7 +74,8 @@ class ReNooiceUI : public UI,
               statCurrent(&frame, theme),
               statAverage(&frame, theme),
               statMinimum(&frame, theme),
-              statMaximum(&frame, theme)
+              statMaximum(&frame, theme),
+              visualization(&frame, theme)
         {
             const double scaleFactor = ui->getScaleFactor() * 1.25;
             const uint smallFontSize = d_roundToUnsignedInt(theme.fontSize - 1.5 * scaleFactor);
@@ -109,7 +116,7 @@ class ReNooiceUI : public UI,
             switchEnableStats.switch_.setLabel("Enable VAD Stats");
 
             statsLabel.label.setCustomFontSize(smallFontSize);
-            statsLabel.label.setLabel("Voice activity detection statistics, running over a period of 2s in round-robin fashion");
+            statsLabel.label.setLabel("Voice activity detection statistics, running over the last 2s by default");
 
             statCurrent.label.setLabel("Current");
             statCurrent.meter.setRange(0, 100);
@@ -148,6 +155,7 @@ class ReNooiceUI : public UI,
             items.push_back(&statAverage);
             items.push_back(&statMinimum);
             items.push_back(&statMaximum);
+            items.push_back(&visualization);
 
             adjustSize(DISTRHO_UI_DEFAULT_WIDTH, DISTRHO_UI_DEFAULT_HEIGHT);
             updateColors();
@@ -174,11 +182,11 @@ class ReNooiceUI : public UI,
             statAverage.adjustSize(metrics);
             statMinimum.adjustSize(metrics);
             statMaximum.adjustSize(metrics);
+            visualization.adjustSize(metrics);
 
             Size<uint> size = VerticallyStackedHorizontalLayout::adjustSize(theme.padding);
-            d_stdout("Default size: %ux%u",
-                     size.getWidth() + theme.padding * 2 + theme.borderSize * 2,
-                     frame.getOffset() + size.getHeight() + theme.padding * 4 + theme.borderSize * 2);
+            minimumHeight = frame.getOffset() + size.getHeight() + theme.padding * 4 + theme.borderSize * 2;
+            d_stdout("Default size: %ux%u", size.getWidth() + theme.padding * 2 + theme.borderSize * 2, minimumHeight);
 
             VerticallyStackedHorizontalLayout::setAbsolutePos(theme.padding,
                                                               frame.getOffset() + theme.padding,
@@ -212,6 +220,10 @@ class ReNooiceUI : public UI,
         }
     } ui;
 
+    // per-frame data from the plugin, drained on idle
+    VisualizationChannel<RENOOICE_NUM_CHANNELS> visualization;
+    VisualizationFrame<RENOOICE_NUM_CHANNELS> visualizationFrames[VisualizationChannel<RENOOICE_NUM_CHANNELS>::kCapacity];
+
 public:
    /**
       UI class constructor.
@@ -222,7 +234,18 @@ public:
           ui(this)
     {
         const double scaleFactor = getScaleFactor();
-        setGeometryConstraints(DISTRHO_UI_DEFAULT_WIDTH * scaleFactor, DISTRHO_UI_DEFAULT_HEIGHT * scaleFactor);
+
+        // theme sizes are truncated after scaling, so the layout does not grow exactly with the scale factor
+        const uint minWidth = DISTRHO_UI_DEFAULT_WIDTH * scaleFactor;
+        const uint minHeight = std::max<uint>(DISTRHO_UI_DEFAULT_HEIGHT * scaleFactor, ui.minimumHeight);
+        setGeometryConstraints(minWidth, minHeight);
+
+        if (getHeight() < minHeight)
+            setSize(getWidth(), minHeight);
+
+       #if RENOOICE_DSP_TIMING
+        ui.visualization.view.setCallback(this);
+       #endif
     }
 
 protected:
@@ -264,6 +287,12 @@ protected:
         case kParamMaximumVAD:
             ui.statMaximum.meter.setValue(value);
             break;
+        case kParamVisualization:
+            if (value > 0.5f)
+                visualization.attach(d_roundToUnsignedInt(value));
+            else
+                visualization.close();
+            break;
         }
     }
 
@@ -322,9 +351,37 @@ protected:
         setParameterValue(widget->getId(), value);
     }
 
+    void timingResetRequested() override
+    {
+       #if RENOOICE_DSP_TIMING
+        editParameter(kParamResetTiming, true);
+        setParameterValue(kParamResetTiming, 1.f);
+        editParameter(kParamResetTiming, false);
+       #endif
+    }
+
     // ----------------------------------------------------------------------------------------------------------------
     // UI Callbacks
 
+   /**
+      Idle callback, called regularly at display rate.
+      Receives everything the plugin sent since last time in a single batch.
+    */
+    void uiIdle() override
+    {
+        if (! visualization.isValid())
+            return;
+
+        const uint32_t numFrames = visualization.read(visualizationFrames, ARRAY_SIZE(visualizationFrames));
+        ui.visualization.view.push(visualizationFrames, numFrames);
+
+       #if RENOOICE_DSP_TIMING
+        uint32_t timingHistogram[kDspTimingNumBuckets];
+        visualization.readTimingHistogram(timingHistogram);
+        ui.visualization.view.setTimingHistogram(timingHistogram);
+       #endif
+    }
+
     void onResize(const ResizeEvent& ev) override
     {
         UI::onResize(ev);
@@ -0,0 +1,154 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef RNN_ENABLE_X86_RTCD
+// cpu detection from rnnoise, renamed at build time so that our own rnn_select_arch can take its place
+extern "C" int rnn_select_arch_detected(void);
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// selection of the RNNoise code path (ISA level), for comparing them against each other.
+// the values match the arch indexes used by rnnoise for its x86 function tables,
+// levels in between (plain SSE and SSE2) run the generic code as those variants are not built.
+// the level in use is picked when a denoise state is created, so changes only apply to states created afterwards.
+
+enum RNNoiseArch {
+    kRNNoiseArchAuto = -1,
+    kRNNoiseArchGeneric = 0,
+    kRNNoiseArchSSE41 = 3,
+    kRNNoiseArchAVX2 = 4
+};
+
+static constexpr const RNNoiseArch kRNNoiseArchs[] = { kRNNoiseArchGeneric, kRNNoiseArchSSE41, kRNNoiseArchAVX2 };
+
+/**
+   Get the name of the code path used for @a arch.
+ */
+static inline const char* getRNNoiseArchName(const int arch) noexcept
+{
+    if (arch >= kRNNoiseArchAVX2)
+        return "avx2";
+    if (arch >= kRNNoiseArchSSE41)
+        return "sse4.1";
+    if (arch >= kRNNoiseArchGeneric)
+        return "generic";
+    return "auto";
+}
+
+/**
+   Parse a code path name as returned by getRNNoiseArchName, returns false if unknown.
+ */
+static inline bool parseRNNoiseArchName(const char* const name, int& arch) noexcept
+{
+    if (std::strcmp(name, "auto") == 0)
+    {
+        arch = kRNNoiseArchAuto;
+        return true;
+    }
+
+    for (const RNNoiseArch a : kRNNoiseArchs)
+    {
+        if (std::strcmp(name, getRNNoiseArchName(a)) == 0)
+        {
+            arch = a;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+   Get the best arch level supported by the CPU and the build.
+ */
+inline int getRNNoiseArchDetected() noexcept
+{
+   #ifdef RNN_ENABLE_X86_RTCD
+    static const int arch = rnn_select_arch_detected();
+    return arch;
+   #else
+    return kRNNoiseArchGeneric;
+   #endif
+}
+
+/**
+   Requested arch level, initially taken from the RENOOICE_ISA environment variable.
+ */
+inline std::atomic<int>& getRNNoiseArchRequest() noexcept
+{
+    static std::atomic<int> request { []() noexcept -> int {
+        const char* const env = std::getenv("RENOOICE_ISA");
+        int arch = kRNNoiseArchAuto;
+
+        if (env == nullptr || env[0] == '\0')
+            return arch;
+
+        if (! parseRNNoiseArchName(env, arch))
+        {
+            d_stderr2("Unknown RENOOICE_ISA value '%s', expected auto, generic, sse4.1 or avx2", env);
+            return kRNNoiseArchAuto;
+        }
+
+        if (arch > getRNNoiseArchDetected())
+            d_stderr2("RENOOICE_ISA=%s is not supported here, using %s instead",
+                      env, getRNNoiseArchName(getRNNoiseArchDetected()));
+
+        return arch;
+    }() };
+
+    return request;
+}
+
+/**
+   Force a specific arch level for denoise states created from now on, or kRNNoiseArchAuto to go back to the default.
+   A forced level takes precedence over auto-tuning.
+   Levels not supported by the CPU are lowered to the best one that is.
+ */
+inline void setRNNoiseArch(const int arch) noexcept
+{
+    getRNNoiseArchRequest().store(arch, std::memory_order_relaxed);
+}
+
+/**
+   Arch level found to be the fastest on this machine, used when none is requested.
+   Set by the auto-tuning in AutoTune.hpp, kRNNoiseArchAuto until then.
+ */
+inline std::atomic<int>& getRNNoiseArchTuned() noexcept
+{
+    static std::atomic<int> tuned { kRNNoiseArchAuto };
+    return tuned;
+}
+
+/**
+   Get the arch level that newly created denoise states will use.
+ */
+inline int getRNNoiseArch() noexcept
+{
+    const int request = getRNNoiseArchRequest().load(std::memory_order_relaxed);
+    const int tuned = getRNNoiseArchTuned().load(std::memory_order_relaxed);
+    const int detected = getRNNoiseArchDetected();
+
+    if (request >= 0)
+        return std::min(request, detected);
+    if (tuned >= 0)
+        return std::min(tuned, detected);
+    return detected;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
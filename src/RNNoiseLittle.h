@@ -0,0 +1,69 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#ifndef RENOOICE_RNNOISE_LITTLE_H_INCLUDED
+#define RENOOICE_RNNOISE_LITTLE_H_INCLUDED
+
+// --------------------------------------------------------------------------------------------------------------------
+// RNNoise built a second time for its builtin little model, which trades some quality for a lot less CPU.
+// layer sizes are compile-time constants in RNNoise, so the model dependent sources (denoise.c, rnn.c and model data)
+// are compiled again through the RNNoiseLittle*.c wrappers, with everything they define renamed.
+// the rest of RNNoise (fft, pitch, nnet kernels and cpu detection) is shared by both models.
+
+#ifdef RENOOICE_RNNOISE_LITTLE_BUILD
+
+// public API
+#define rnnoise_get_size             rnnoise_little_get_size
+#define rnnoise_get_frame_size       rnnoise_little_get_frame_size
+#define rnnoise_init                 rnnoise_little_init
+#define rnnoise_create               rnnoise_little_create
+#define rnnoise_destroy              rnnoise_little_destroy
+#define rnnoise_process_frame        rnnoise_little_process_frame
+#define rnnoise_model_from_buffer    rnnoise_little_model_from_buffer
+#define rnnoise_model_from_file      rnnoise_little_model_from_file
+#define rnnoise_model_from_filename  rnnoise_little_model_from_filename
+#define rnnoise_model_free           rnnoise_little_model_free
+
+// internals without static linkage, the ones that are static get renamed harmlessly
+#define compute_band_energy          rnnoise_little_compute_band_energy
+#define compute_band_corr            rnnoise_little_compute_band_corr
+#define interp_band_gain             rnnoise_little_interp_band_gain
+#define rnn_frame_analysis           rnnoise_little_frame_analysis
+#define rnn_compute_frame_features   rnnoise_little_compute_frame_features
+#define rnn_pitch_filter             rnnoise_little_pitch_filter
+#define compute_rnn                  rnnoise_little_compute_rnn
+#define init_rnnoise                 rnnoise_little_init_model
+#define rnnoise_arrays               rnnoise_little_arrays
+
+// little model layer sizes, then skip the regular model header included by the RNNoise sources
+#include "rnnoise_data_little.h"
+#ifndef RNNOISE_DATA_H
+#define RNNOISE_DATA_H
+#endif
+
+#else // RENOOICE_RNNOISE_LITTLE_BUILD
+
+#include "rnnoise.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// same as the regular RNNoise API, for the little model
+int rnnoise_little_get_frame_size(void);
+DenoiseState* rnnoise_little_create(RNNModel* model);
+void rnnoise_little_destroy(DenoiseState* st);
+float rnnoise_little_process_frame(DenoiseState* st, float* out, const float* in);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RENOOICE_RNNOISE_LITTLE_BUILD
+
+// --------------------------------------------------------------------------------------------------------------------
+
+#endif // RENOOICE_RNNOISE_LITTLE_H_INCLUDED
@@ -0,0 +1,11 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// little model data from RNNoise, built with the same renaming as its sources, see RNNoiseLittle.h
+
+#define RENOOICE_RNNOISE_LITTLE_BUILD
+#include "RNNoiseLittle.h"
+#include "rnnoise_data_little.c"
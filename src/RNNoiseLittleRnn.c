@@ -0,0 +1,11 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// rnn.c from RNNoise, built again for the little model, see RNNoiseLittle.h
+
+#define RENOOICE_RNNOISE_LITTLE_BUILD
+#include "RNNoiseLittle.h"
+#include "rnn.c"
@@ -0,0 +1,221 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "extra/Mutex.hpp"
+#include "extra/String.hpp"
+
+#include "rnnoise.h"
+
+#include <climits>
+#include <cstdlib>
+
+#ifdef DISTRHO_OS_WINDOWS
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// RNNoise model loaded from a weights file, shared by all plugin instances in the process
+// the file is memory-mapped read-only and RNNoise points directly into it, so its pages are only loaded once
+
+class SharedModel
+{
+public:
+   /**
+      Get the model for @a filename, loading it if not in use yet.
+      Returns null and logs the reason if the file cannot be found, mapped or is not a valid model.
+      Must be paired with release(), never call this from the audio thread.
+    */
+    static SharedModel* acquire(const char* const filename)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', nullptr);
+
+        // different spellings of the same file must share a single mapping
+        const String path(getCanonicalPath(filename));
+
+        if (path.isEmpty())
+        {
+            d_stderr2("Cannot find RNNoise model file '%s'", filename);
+            return nullptr;
+        }
+
+        const MutexLocker cml(getMutex());
+
+        for (SharedModel* m = getFirst(); m != nullptr; m = m->next)
+        {
+            if (m->filename == path)
+            {
+                ++m->refcount;
+                return m;
+            }
+        }
+
+        SharedModel* const m = new SharedModel(path);
+
+        if (m->data == nullptr || m->model == nullptr)
+        {
+            delete m;
+            return nullptr;
+        }
+
+        m->next = getFirst();
+        getFirst() = m;
+        return m;
+    }
+
+   /**
+      Release a model obtained with acquire(), unmapping it once no longer used.
+    */
+    static void release(SharedModel* const model)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(model != nullptr,);
+
+        const MutexLocker cml(getMutex());
+
+        if (--model->refcount != 0)
+            return;
+
+        for (SharedModel** m = &getFirst(); *m != nullptr; m = &(*m)->next)
+        {
+            if (*m == model)
+            {
+                *m = model->next;
+                break;
+            }
+        }
+
+        delete model;
+    }
+
+    RNNModel* getModel() const noexcept
+    {
+        return model;
+    }
+
+private:
+    const String filename;
+    uint32_t refcount = 1;
+    SharedModel* next = nullptr;
+
+    RNNModel* model = nullptr;
+    void* data = nullptr;
+    size_t size = 0;
+   #ifdef DISTRHO_OS_WINDOWS
+    HANDLE mapping = nullptr;
+   #endif
+
+    SharedModel(const char* const fname)
+        : filename(fname)
+    {
+       #ifdef DISTRHO_OS_WINDOWS
+        const HANDLE file = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            d_stderr2("Failed to open RNNoise model file '%s'", fname);
+            return;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && fileSize.QuadPart < INT32_MAX)
+        {
+            size = static_cast<size_t>(fileSize.QuadPart);
+
+            if ((mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) != nullptr)
+                data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+
+        CloseHandle(file);
+       #else
+        const int fd = open(fname, O_RDONLY);
+        if (fd < 0)
+        {
+            d_stderr2("Failed to open RNNoise model file '%s'", fname);
+            return;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size < INT32_MAX)
+        {
+            size = static_cast<size_t>(st.st_size);
+            data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+            if (data == MAP_FAILED)
+                data = nullptr;
+        }
+
+        close(fd);
+       #endif
+
+        if (data == nullptr)
+        {
+            d_stderr2("Failed to map RNNoise model file '%s'", fname);
+            return;
+        }
+
+        model = rnnoise_model_from_buffer(data, static_cast<int>(size));
+
+        if (model == nullptr)
+            d_stderr2("Invalid RNNoise model file '%s'", fname);
+    }
+
+    ~SharedModel()
+    {
+        if (model != nullptr)
+            rnnoise_model_free(model);
+
+       #ifdef DISTRHO_OS_WINDOWS
+        if (data != nullptr)
+            UnmapViewOfFile(data);
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+       #else
+        if (data != nullptr)
+            munmap(data, size);
+       #endif
+    }
+
+    static String getCanonicalPath(const char* const filename)
+    {
+       #ifdef DISTRHO_OS_WINDOWS
+        char path[MAX_PATH];
+        if (_fullpath(path, filename, MAX_PATH) == nullptr)
+            return String();
+       #else
+        char path[PATH_MAX];
+        if (realpath(filename, path) == nullptr)
+            return String();
+       #endif
+
+        return String(path);
+    }
+
+    static Mutex& getMutex()
+    {
+        static Mutex mutex;
+        return mutex;
+    }
+
+    static SharedModel*& getFirst()
+    {
+        static SharedModel* first = nullptr;
+        return first;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(SharedModel)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,184 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// average, minimum and maximum over a sliding window of the most recent values, in constant time per value
+// the average comes from a running sum, minimum and maximum from monotonic queues of positions within the window.
+// storage is fixed at compile time, the window length can be changed at any time up to that capacity.
+
+template <uint32_t kCapacity>
+class SlidingStats
+{
+    static_assert(kCapacity != 0 && (kCapacity & (kCapacity - 1)) == 0, "capacity must be a power of 2");
+
+    static constexpr const uint32_t kMask = kCapacity - 1;
+
+    // positions of values in history, in order, each one kept while no later value beats it
+    struct MonotonicQueue {
+        uint32_t positions[kCapacity];
+        uint32_t head, tail;
+    };
+
+public:
+    SlidingStats() noexcept
+    {
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        pos = 0;
+        numStored = 0;
+        clearWindow();
+    }
+
+   /**
+      Change the window to the last @a frames values, clamped to the capacity.
+      Values still in history are reused, so a longer window fills up again from the past right away.
+      Only values entering or leaving the window are looked at, so gradual changes are cheap too.
+    */
+    void setWindowSize(uint32_t frames) noexcept
+    {
+        frames = std::max(1u, std::min(frames, kCapacity));
+
+        if (windowSize == frames)
+            return;
+
+        windowSize = frames;
+
+        // older values join at the front
+        for (const uint32_t target = std::min(numStored, windowSize); numInWindow < target;)
+            pushFront(pos - numInWindow - 1);
+
+        // oldest values leave from the front
+        while (numInWindow > windowSize)
+            popFront(pos - numInWindow);
+    }
+
+    void store(const float value) noexcept
+    {
+        // the oldest value leaves the window, read it before it gets overwritten
+        if (numInWindow == windowSize)
+            sum -= history[(pos - windowSize) & kMask];
+
+        history[pos & kMask] = value;
+
+        if (numStored != kCapacity)
+            ++numStored;
+
+        push(pos++);
+    }
+
+    float getAverage() const noexcept
+    {
+        return numInWindow != 0 ? static_cast<float>(sum / numInWindow) : 0.f;
+    }
+
+    float getMinimum() const noexcept
+    {
+        return minQueue.head != minQueue.tail ? history[minQueue.positions[minQueue.head & kMask] & kMask] : 1.f;
+    }
+
+    float getMaximum() const noexcept
+    {
+        return maxQueue.head != maxQueue.tail ? history[maxQueue.positions[maxQueue.head & kMask] & kMask] : 0.f;
+    }
+
+private:
+    float history[kCapacity];
+    uint32_t pos;
+    uint32_t numStored;
+    uint32_t windowSize = 1;
+
+    // running window state, only depends on history
+    // double precision keeps rounding drift of the running sum negligible over long sessions
+    double sum;
+    uint32_t numInWindow;
+    MonotonicQueue minQueue, maxQueue;
+
+    void clearWindow() noexcept
+    {
+        sum = 0.0;
+        numInWindow = 0;
+        minQueue.head = minQueue.tail = 0;
+        maxQueue.head = maxQueue.tail = 0;
+    }
+
+    // add value at position @a p of history to the window, positions must be pushed in order.
+    // a full window has its oldest value already removed from the sum by store()
+    void push(const uint32_t p) noexcept
+    {
+        const float value = history[p & kMask];
+
+        if (numInWindow != windowSize)
+            ++numInWindow;
+
+        sum += value;
+
+        pushTo(minQueue, p, value, [](const float a, const float b) { return a <= b; });
+        pushTo(maxQueue, p, value, [](const float a, const float b) { return a >= b; });
+    }
+
+    // add value at position @a p of history to the window, right before the oldest one in it
+    void pushFront(const uint32_t p) noexcept
+    {
+        const float value = history[p & kMask];
+
+        ++numInWindow;
+        sum += value;
+
+        pushFrontTo(minQueue, p, value, [](const float a, const float b) { return a <= b; });
+        pushFrontTo(maxQueue, p, value, [](const float a, const float b) { return a >= b; });
+    }
+
+    // remove the oldest value from the window, at position @a p of history
+    void popFront(const uint32_t p) noexcept
+    {
+        --numInWindow;
+        sum -= history[p & kMask];
+
+        if (minQueue.head != minQueue.tail && minQueue.positions[minQueue.head & kMask] == p)
+            ++minQueue.head;
+        if (maxQueue.head != maxQueue.tail && maxQueue.positions[maxQueue.head & kMask] == p)
+            ++maxQueue.head;
+    }
+
+    template <typename Beats>
+    void pushFrontTo(MonotonicQueue& queue, const uint32_t p, const float value, const Beats beats) noexcept
+    {
+        // the front of the queue is the best of all later values, an older value only matters if it beats that
+        if (queue.head != queue.tail && beats(history[queue.positions[queue.head & kMask] & kMask], value))
+            return;
+
+        queue.positions[--queue.head & kMask] = p;
+    }
+
+    template <typename Beats>
+    void pushTo(MonotonicQueue& queue, const uint32_t p, const float value, const Beats beats) noexcept
+    {
+        // drop positions that fell out of the window
+        while (queue.head != queue.tail && p - queue.positions[queue.head & kMask] >= windowSize)
+            ++queue.head;
+
+        // drop older values that can never be the result again
+        while (queue.head != queue.tail && beats(value, history[queue.positions[(queue.tail - 1) & kMask] & kMask]))
+            --queue.tail;
+
+        queue.positions[queue.tail++ & kMask] = p;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
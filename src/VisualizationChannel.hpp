@@ -0,0 +1,417 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DspTiming.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifdef DISTRHO_OS_WINDOWS
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+// octave bands used for visualization, center frequencies at the 48kHz denoise rate
+
+static constexpr const uint32_t kVisualizationNumBands = 8;
+
+static constexpr const float kVisualizationBandCenters[kVisualizationNumBands] = {
+    125.f, 250.f, 500.f, 1000.f, 2000.f, 4000.f, 8000.f, 16000.f
+};
+
+/**
+   Everything the UI gets to know about a single denoise frame.
+   Band energies are the mean square of all channels summed, at regular audio level.
+ */
+template <uint32_t kNumChannels>
+struct VisualizationFrame {
+    float vads[kNumChannels];
+    float muteGains[kNumChannels];
+    float inputEnergy[kVisualizationNumBands];
+    float outputEnergy[kVisualizationNumBands];
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// denoise frames sent from plugin to UI through a named shared memory segment, so it also works out-of-process
+// there is a single writer (the audio thread) and a single passive reader (the UI), neither of them ever waits.
+// the writer fills the next slot and publishes it with a single store, overwriting old frames no matter what.
+// the reader copies frames out and then checks the write position again, discarding any that got overwritten
+// in the meantime, so it never sees torn frames.
+// the segment is identified by a 24-bit id, which fits exactly into a float parameter value.
+
+template <uint32_t kNumChannels>
+class VisualizationChannel
+{
+public:
+    typedef VisualizationFrame<kNumChannels> Frame;
+
+    // 5 seconds worth of denoise frames, a power of 2
+    static constexpr const uint32_t kCapacity = 512;
+
+    VisualizationChannel() noexcept = default;
+
+    ~VisualizationChannel()
+    {
+        close();
+    }
+
+   /**
+      Create a new segment, as writer.
+      Returns its id, or 0 on failure.
+    */
+    uint32_t create()
+    {
+        close();
+
+        // pick unused ids, based on process and instance
+        static std::atomic<uint32_t> counter { 0 };
+       #ifdef DISTRHO_OS_WINDOWS
+        const uint32_t seed = static_cast<uint32_t>(GetCurrentProcessId());
+       #else
+        const uint32_t seed = static_cast<uint32_t>(getpid());
+       #endif
+
+        for (uint32_t attempt = 0; attempt < 16; ++attempt)
+        {
+            uint32_t newId = (seed * 2654435761u) ^ ((counter++ + 1) * 40503u);
+            newId = (newId ^ (newId >> 24)) & 0xffffff;
+
+            if (newId == 0)
+                continue;
+
+            if (! open(newId, true))
+                continue;
+
+            data->magic = kMagic;
+            data->writePos.store(0, std::memory_order_relaxed);
+            data->readPos.store(static_cast<uint32_t>(-kCapacity), std::memory_order_relaxed);
+
+            for (uint32_t b = 0; b < kDspTimingNumBuckets; ++b)
+                data->timingHistogram[b].store(0, std::memory_order_relaxed);
+
+            return id;
+        }
+
+        d_stderr2("Failed to create visualization channel");
+        return 0;
+    }
+
+   /**
+      Attach to an existing segment with @a newId, as reader.
+    */
+    bool attach(const uint32_t newId)
+    {
+        if (newId == id && data != nullptr)
+            return true;
+
+        close();
+
+        if (newId == 0 || ! open(newId, false))
+            return false;
+
+        if (data->magic != kMagic)
+        {
+            close();
+            return false;
+        }
+
+        readPos = data->writePos.load(std::memory_order_acquire);
+        data->readPos.store(readPos, std::memory_order_release);
+        return true;
+    }
+
+    void close()
+    {
+        if (data == nullptr)
+            return;
+
+       #ifdef DISTRHO_OS_WINDOWS
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        mapping = nullptr;
+       #else
+        munmap(data, sizeof(Data));
+
+        if (owner)
+        {
+            char name[32];
+            getName(name, id);
+            shm_unlink(name);
+        }
+       #endif
+
+        data = nullptr;
+        id = 0;
+        owner = false;
+    }
+
+    bool isValid() const noexcept
+    {
+        return data != nullptr;
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // writer side
+
+   /**
+      Check if a reader has been draining frames recently.
+      Can be used to skip work only needed for visualization.
+    */
+    bool isReaderActive() const noexcept
+    {
+        return data->writePos.load(std::memory_order_relaxed) - data->readPos.load(std::memory_order_relaxed) < kCapacity;
+    }
+
+   /**
+      Get the next frame for writing, always succeeds.
+    */
+    Frame* getWriteFrame() const noexcept
+    {
+        return &data->frames[data->writePos.load(std::memory_order_relaxed) & kMask];
+    }
+
+    void commitWrite() noexcept
+    {
+        data->writePos.store(data->writePos.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+   /**
+      Share the histogram of denoise block processing times, as counted by BlockTimingStats.
+    */
+    void writeTimingHistogram(const uint32_t* const counts) noexcept
+    {
+        for (uint32_t b = 0; b < kDspTimingNumBuckets; ++b)
+            data->timingHistogram[b].store(counts[b], std::memory_order_relaxed);
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // reader side
+
+   /**
+      Copy up to @a maxFrames of the frames written since last time into @a frames, oldest first.
+      Frames that were overwritten before being read are skipped.
+      Returns the number of frames copied.
+    */
+    uint32_t read(Frame* const frames, const uint32_t maxFrames) noexcept
+    {
+        const uint32_t writePos = data->writePos.load(std::memory_order_acquire);
+
+        // fell behind, skip to the oldest frame still there
+        if (writePos - readPos > kCapacity)
+            readPos = writePos - kCapacity;
+
+        uint32_t numFrames = std::min(writePos - readPos, maxFrames);
+
+        for (uint32_t i = 0; i < numFrames; ++i)
+            std::memcpy(&frames[i], &data->frames[(readPos + i) & kMask], sizeof(Frame));
+
+        // the writer may have gone around and overwritten some of the oldest frames while copying
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint32_t overwritten = data->writePos.load(std::memory_order_relaxed) + 1 - kCapacity - readPos;
+
+        if (static_cast<int32_t>(overwritten) > 0)
+        {
+            const uint32_t skip = std::min(overwritten, numFrames);
+            std::memmove(frames, frames + skip, sizeof(Frame) * (numFrames - skip));
+            numFrames -= skip;
+            readPos += skip;
+        }
+
+        readPos += numFrames;
+        data->readPos.store(readPos, std::memory_order_release);
+        return numFrames;
+    }
+
+    void readTimingHistogram(uint32_t counts[kDspTimingNumBuckets]) const noexcept
+    {
+        for (uint32_t b = 0; b < kDspTimingNumBuckets; ++b)
+            counts[b] = data->timingHistogram[b].load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr const uint32_t kMask = kCapacity - 1;
+
+    // changes with layout, so mismatched plugin and UI binaries refuse to talk to each other
+    static constexpr const uint32_t kMagic = 0x564e0000 + sizeof(Frame);
+
+    struct Data {
+        uint32_t magic;
+        alignas(64) std::atomic<uint32_t> writePos;
+        alignas(64) std::atomic<uint32_t> readPos;
+        alignas(64) std::atomic<uint32_t> timingHistogram[kDspTimingNumBuckets];
+        alignas(64) Frame frames[kCapacity];
+    };
+
+    Data* data = nullptr;
+    uint32_t id = 0;
+    uint32_t readPos = 0;
+    bool owner = false;
+   #ifdef DISTRHO_OS_WINDOWS
+    HANDLE mapping = nullptr;
+   #endif
+
+    static void getName(char name[32], const uint32_t id) noexcept
+    {
+       #ifdef DISTRHO_OS_WINDOWS
+        std::snprintf(name, 32, "Local\\renooice-vis-%06x", id);
+       #else
+        std::snprintf(name, 32, "/renooice-vis-%06x", id);
+       #endif
+    }
+
+    bool open(const uint32_t newId, const bool create)
+    {
+        char name[32];
+        getName(name, newId);
+
+       #ifdef DISTRHO_OS_WINDOWS
+        if (create)
+        {
+            mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(Data), name);
+
+            if (mapping != nullptr && GetLastError() == ERROR_ALREADY_EXISTS)
+            {
+                CloseHandle(mapping);
+                mapping = nullptr;
+            }
+        }
+        else
+        {
+            mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+        }
+
+        if (mapping == nullptr)
+            return false;
+
+        void* const ptr = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Data));
+
+        if (ptr == nullptr)
+        {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return false;
+        }
+       #else
+        const int fd = shm_open(name, create ? O_CREAT|O_EXCL|O_RDWR : O_RDWR, 0600);
+
+        if (fd < 0)
+            return false;
+
+        if (create && ftruncate(fd, sizeof(Data)) != 0)
+        {
+            ::close(fd);
+            shm_unlink(name);
+            return false;
+        }
+
+        struct stat st;
+        void* ptr = MAP_FAILED;
+
+        if (fstat(fd, &st) == 0 && st.st_size == static_cast<off_t>(sizeof(Data)))
+            ptr = mmap(nullptr, sizeof(Data), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+
+        ::close(fd);
+
+        if (ptr == MAP_FAILED)
+        {
+            if (create)
+                shm_unlink(name);
+            return false;
+        }
+       #endif
+
+        data = static_cast<Data*>(ptr);
+        id = newId;
+        owner = create;
+        return true;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(VisualizationChannel)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// per-band energy of a signal, through a bank of octave-wide band-pass filters running at the denoise rate
+
+template <uint32_t kNumChannels>
+class BandEnergyAnalyzer
+{
+public:
+    BandEnergyAnalyzer() noexcept
+    {
+        for (uint32_t b = 0; b < kVisualizationNumBands; ++b)
+        {
+            // constant peak gain band-pass, 1 octave wide
+            const double w0 = 2.0 * 3.141592653589793 * kVisualizationBandCenters[b] / 48000.0;
+            const double alpha = std::sin(w0) * std::sinh(std::log(2.0) / 2.0 * w0 / std::sin(w0));
+            const double a0 = 1.0 + alpha;
+
+            coeffs[b].b0 = static_cast<float>(alpha / a0);
+            coeffs[b].a1 = static_cast<float>(-2.0 * std::cos(w0) / a0);
+            coeffs[b].a2 = static_cast<float>((1.0 - alpha) / a0);
+        }
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::memset(states, 0, sizeof(states));
+    }
+
+   /**
+      Add the energy of @a frames of @a channel from @a buffer to @a energy, per band.
+      Every call updates filter state, so channels must always be given in the same way.
+    */
+    void process(const uint32_t channel, const float* const buffer, const uint32_t frames,
+                 float energy[kVisualizationNumBands]) noexcept
+    {
+        const float norm = 1.f / frames;
+
+        for (uint32_t b = 0; b < kVisualizationNumBands; ++b)
+        {
+            const Coeffs& k(coeffs[b]);
+            State& s(states[channel][b]);
+            float sum = 0.f;
+
+            // transposed direct form II, b1 is 0 and b2 is -b0
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                const float x = buffer[i];
+                const float y = k.b0 * x + s.z1;
+                s.z1 = s.z2 - k.a1 * y;
+                s.z2 = -k.b0 * x - k.a2 * y;
+                sum += y * y;
+            }
+
+            energy[b] += sum * norm;
+        }
+    }
+
+private:
+    struct Coeffs {
+        float b0, a1, a2;
+    } coeffs[kVisualizationNumBands];
+
+    struct State {
+        float z1, z2;
+    } states[kNumChannels][kVisualizationNumBands];
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
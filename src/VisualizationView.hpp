@@ -0,0 +1,244 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "Quantum.hpp"
+#include "VisualizationChannel.hpp"
+
+START_NAMESPACE_DGL
+
+// --------------------------------------------------------------------------------------------------------------------
+// scrolling history of voice activity and mute gain, plus how much is removed per band
+// and a histogram of denoise block processing times, which can be clicked to reset
+
+template <uint32_t kNumChannels>
+class VisualizationView : public NanoSubWidget
+{
+public:
+    typedef DISTRHO_NAMESPACE::VisualizationFrame<kNumChannels> Frame;
+
+    struct Callback {
+        virtual ~Callback() {}
+        virtual void timingResetRequested() = 0;
+    };
+
+    // 3 seconds worth of denoise frames
+    static constexpr const uint32_t kHistorySize = 300;
+
+    explicit VisualizationView(NanoSubWidget* const parent, const QuantumTheme& t)
+        : NanoSubWidget(parent),
+          theme(t) {}
+
+   /**
+      Add a batch of frames received from the plugin, then repaint.
+    */
+    void push(const Frame* const frames, const uint32_t numFrames)
+    {
+        for (uint32_t i = 0; i < numFrames; ++i)
+        {
+            const Frame& frame(frames[i]);
+            float vad = 0.f, gain = 0.f;
+
+            for (uint32_t c = 0; c < kNumChannels; ++c)
+            {
+                vad = std::max(vad, frame.vads[c]);
+                gain = std::max(gain, frame.muteGains[c]);
+            }
+
+            vadHistory[historyPos] = vad;
+            gainHistory[historyPos] = gain;
+            historyPos = (historyPos + 1) % kHistorySize;
+
+            // keep energy bars steady, following rises right away and falls slowly
+            for (uint32_t b = 0; b < DISTRHO_NAMESPACE::kVisualizationNumBands; ++b)
+            {
+                inputLevels[b] = std::max(toLevel(frame.inputEnergy[b]), inputLevels[b] - kLevelFallPerFrame);
+                outputLevels[b] = std::max(toLevel(frame.outputEnergy[b]), outputLevels[b] - kLevelFallPerFrame);
+            }
+        }
+
+        if (numFrames != 0)
+            repaint();
+    }
+
+    void setCallback(Callback* const cb) noexcept
+    {
+        callback = cb;
+    }
+
+    void setTimingHistogram(const uint32_t counts[DISTRHO_NAMESPACE::kDspTimingNumBuckets])
+    {
+        if (std::memcmp(timingHistogram, counts, sizeof(timingHistogram)) == 0)
+            return;
+
+        std::memcpy(timingHistogram, counts, sizeof(timingHistogram));
+        repaint();
+    }
+
+protected:
+    void onNanoDisplay() override
+    {
+        const float width = getWidth();
+        const float height = getHeight();
+        const float lineSize = theme.widgetLineSize;
+
+        // band levels and timing on the right, history takes the rest
+        const float timingWidth = getTimingWidth();
+        const float bandsWidth = std::min(width * 0.3f, height * 2.f);
+        const float historyWidth = width - timingWidth - bandsWidth - theme.padding * 2;
+        const float step = historyWidth / (kHistorySize - 1);
+
+        beginPath();
+        rect(0, 0, width, height);
+        fillColor(withAlpha(theme.textDarkColor, 0.1f));
+        fill();
+
+        // mute gain as filled area, voice activity as line on top
+        beginPath();
+        moveTo(0, height);
+        for (uint32_t i = 0; i < kHistorySize; ++i)
+            lineTo(step * i, height - gainHistory[(historyPos + i) % kHistorySize] * height);
+        lineTo(historyWidth, height);
+        closePath();
+        fillColor(withAlpha(theme.textDarkColor, 0.5f));
+        fill();
+
+        beginPath();
+        for (uint32_t i = 0; i < kHistorySize; ++i)
+        {
+            const float y = height - vadHistory[(historyPos + i) % kHistorySize] * (height - lineSize) - lineSize * 0.5f;
+
+            if (i == 0)
+                moveTo(0, y);
+            else
+                lineTo(step * i, y);
+        }
+        strokeColor(theme.textLightColor);
+        strokeWidth(lineSize);
+        stroke();
+
+        // input level as outline, output level as solid bar, the gap in between is what got removed
+        const float bandWidth = bandsWidth / DISTRHO_NAMESPACE::kVisualizationNumBands;
+        const float bandsX = width - timingWidth - theme.padding - bandsWidth;
+
+        for (uint32_t b = 0; b < DISTRHO_NAMESPACE::kVisualizationNumBands; ++b)
+        {
+            const float x = bandsX + bandWidth * b + lineSize;
+            const float w = bandWidth - lineSize * 2;
+            const float hIn = inputLevels[b] * height;
+            const float hOut = outputLevels[b] * height;
+
+            beginPath();
+            rect(x, height - hIn, w, hIn);
+            strokeColor(theme.textDarkColor);
+            strokeWidth(lineSize);
+            stroke();
+
+            beginPath();
+            rect(x, height - hOut, w, hOut);
+            fillColor(theme.textLightColor);
+            fill();
+        }
+
+        // processing time histogram, relative to the most common time, with blocks over budget in red
+        uint32_t maxCount = 1;
+        for (uint32_t b = 0; b < DISTRHO_NAMESPACE::kDspTimingNumBuckets; ++b)
+            maxCount = std::max(maxCount, timingHistogram[b]);
+
+        const float bucketWidth = timingWidth / DISTRHO_NAMESPACE::kDspTimingNumBuckets;
+        const float timingX = width - timingWidth;
+
+        for (uint32_t b = 0; b < DISTRHO_NAMESPACE::kDspTimingNumBuckets; ++b)
+        {
+            if (timingHistogram[b] == 0)
+                continue;
+
+            // show rare buckets too, as those are usually the interesting ones
+            const float h = std::max(lineSize, static_cast<float>(timingHistogram[b]) / maxCount * height);
+
+            beginPath();
+            rect(timingX + bucketWidth * b, height - h, bucketWidth, h);
+            fillColor(static_cast<int>(b) >= DISTRHO_NAMESPACE::kDspTimingBudgetBucket ? Color(0xe0, 0x40, 0x40)
+                                                                                        : theme.textDarkColor);
+            fill();
+        }
+    }
+
+    bool onMouse(const MouseEvent& ev) override
+    {
+        if (! ev.press || ev.button != 1 || callback == nullptr)
+            return false;
+
+        if (! contains(ev.pos) || ev.pos.getX() < getWidth() - getTimingWidth())
+            return false;
+
+        callback->timingResetRequested();
+        return true;
+    }
+
+private:
+    const QuantumTheme& theme;
+    Callback* callback = nullptr;
+
+    // energy levels are shown from -80dB to 0dB
+    static constexpr const float kLevelRangeDB = 80.f;
+    static constexpr const float kLevelFallPerFrame = 0.25f / 100.f;
+
+    float vadHistory[kHistorySize] = {};
+    float gainHistory[kHistorySize] = {};
+    uint32_t historyPos = 0;
+
+    float inputLevels[DISTRHO_NAMESPACE::kVisualizationNumBands] = {};
+    float outputLevels[DISTRHO_NAMESPACE::kVisualizationNumBands] = {};
+
+    uint32_t timingHistogram[DISTRHO_NAMESPACE::kDspTimingNumBuckets] = {};
+
+    float getTimingWidth() const noexcept
+    {
+        return std::min(getWidth() * 0.2f, getHeight() * 1.5f);
+    }
+
+    static Color withAlpha(Color color, const float alpha) noexcept
+    {
+        color.alpha = alpha;
+        return color;
+    }
+
+    static float toLevel(const float energy) noexcept
+    {
+        if (energy <= 0.f)
+            return 0.f;
+
+        return std::max(0.f, std::min(1.f, 1.f + 10.f * std::log10(energy) / kLevelRangeDB));
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(VisualizationView)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// expanding visualization view
+
+template <uint32_t kNumChannels>
+struct QuantumVisualization : HorizontalLayout
+{
+    VisualizationView<kNumChannels> view;
+
+    explicit QuantumVisualization(NanoSubWidget* const parent, const QuantumTheme& theme)
+        : view(parent, theme)
+    {
+        widgets.push_back({ &view, Expanding });
+    }
+
+    void adjustSize(const QuantumMetrics& metrics)
+    {
+        view.setHeight(metrics.valueMeterHorizontal.getHeight() * 4);
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DGL
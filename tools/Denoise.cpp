@@ -0,0 +1,749 @@
+/*
+ * Re:Nooice
+ * Copyright (C) 2025 Filipe Coelho <falktx@falktx.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// offline denoiser for many files at once, running the plugin through DPF without a host.
+// each worker thread takes the next job from the list and processes it from start to end,
+// a job being a whole file or, when splitting long files, a segment of one.
+
+#include "src/DistrhoPlugin.cpp"
+#include "src/DistrhoUtils.cpp"
+
+#include "AudioFile.hpp"
+#include "DspTiming.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static constexpr const uint32_t kNumChannels = DISTRHO_PLUGIN_NUM_INPUTS;
+
+// warm-up lengths tried for the warm-up report, in milliseconds
+static constexpr const uint32_t kReportWarmups[] = { 0, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+
+// how much output after each segment start is compared for the warm-up report, in seconds
+static constexpr const uint32_t kReportCompareSeconds = 5;
+
+// a difference below this level, relative to full scale, counts as settled for the warm-up report
+static constexpr const double kReportSettledDB = -60.0;
+
+struct Options {
+    std::vector<const char*> inputFilenames;
+    const char* outputDir = nullptr;
+    const char* modelFilename = nullptr;
+    uint32_t numJobs = 0;
+    float threshold = -1.f;
+    float gracePeriod = -1.f;
+    bool vadTimeline = false;
+    bool trimSilence = false;
+    double segmentSeconds = 0.0;
+    double warmupSeconds = 1.0;
+    bool warmupReport = false;
+};
+
+// plugins get their buffer size and sample rate from DPF globals, so they must be created one at a time
+static std::mutex pluginCreationMutex;
+
+// keeps progress lines from different threads apart
+static std::mutex printMutex;
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static std::string getOutputFilename(const std::string& inputFilename, const char* const outputDir)
+{
+   #ifdef DISTRHO_OS_WINDOWS
+    const size_t sep = inputFilename.find_last_of("/\\");
+   #else
+    const size_t sep = inputFilename.rfind('/');
+   #endif
+    const std::string name = sep != std::string::npos ? inputFilename.substr(sep + 1) : inputFilename;
+
+    if (outputDir != nullptr)
+        return std::string(outputDir) + "/" + name;
+
+    const std::string dir = sep != std::string::npos ? inputFilename.substr(0, sep + 1) : std::string();
+    const size_t dot = name.rfind('.');
+
+    if (dot == std::string::npos || dot == 0)
+        return dir + name + "-denoised";
+
+    return dir + name.substr(0, dot) + "-denoised" + name.substr(dot);
+}
+
+static std::string getTimelineFilename(const std::string& outputFilename)
+{
+    const size_t dot = outputFilename.rfind('.');
+    const size_t sep = outputFilename.find_last_of("/\\");
+
+    if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+        return outputFilename + ".vad.csv";
+
+    return outputFilename.substr(0, dot) + ".vad.csv";
+}
+
+// 10ms per cycle, the duration of a denoise block, so every cycle has its own VAD value
+static uint32_t getCycleSize(const AudioFileInfo& info) noexcept
+{
+    return std::max(1u, (info.sampleRate + 50) / 100);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Denoise frames from @a start to @a end of an opened file, with as many plugin instances as needed for its channels.
+   Processing begins at @a warmupStart, so the recurrent state of the model has settled once kept output starts,
+   the output before @a start is discarded.
+   The first latency frames of output are dropped and the audio following @a end is used to push out the rest,
+   so output lines up with input. Output is passed to @a callback in cycles of 10ms or less.
+ */
+template <class Callback>
+static bool denoiseRange(AudioFileReader& reader,
+                         const Options& options,
+                         const uint64_t warmupStart,
+                         const uint64_t start,
+                         const uint64_t end,
+                         Callback&& callback)
+{
+    const AudioFileInfo& info(reader.getInfo());
+    const uint32_t cycleSize = getCycleSize(info);
+    const uint32_t numInstances = (info.numChannels + kNumChannels - 1) / kNumChannels;
+    const uint32_t numPaddedChannels = numInstances * kNumChannels;
+
+    std::vector<std::unique_ptr<PluginExporter>> plugins;
+
+    {
+        const std::lock_guard<std::mutex> lock(pluginCreationMutex);
+
+        d_nextBufferSize = cycleSize;
+        d_nextSampleRate = info.sampleRate;
+
+        for (uint32_t i = 0; i < numInstances; ++i)
+            plugins.emplace_back(new PluginExporter(nullptr, nullptr, nullptr, nullptr));
+    }
+
+    for (std::unique_ptr<PluginExporter>& plugin : plugins)
+    {
+       #ifndef SIMPLIFIED_NOOICE
+        if (options.threshold >= 0.f)
+            plugin->setParameterValue(kParamThreshold, options.threshold);
+        if (options.gracePeriod >= 0.f)
+            plugin->setParameterValue(kParamGracePeriod, options.gracePeriod);
+        if (options.vadTimeline)
+            plugin->setParameterValue(kParamEnableStats, 1.f);
+       #endif
+
+        if (options.modelFilename != nullptr)
+            plugin->setState("model", options.modelFilename);
+
+        plugin->activate();
+    }
+
+    if (! reader.seek(warmupStart))
+        return false;
+
+    std::vector<float> buffers(static_cast<size_t>(numPaddedChannels) * cycleSize * 2);
+    std::vector<float*> inputs(numPaddedChannels), outputs(numPaddedChannels);
+    std::vector<const float*> keptOutputs(info.numChannels);
+
+    for (uint32_t c = 0; c < numPaddedChannels; ++c)
+    {
+        inputs[c] = buffers.data() + c * cycleSize;
+        outputs[c] = buffers.data() + (numPaddedChannels + c) * cycleSize;
+    }
+
+    uint32_t latencyToSkip = plugins[0]->getLatency();
+    uint64_t outputPos = warmupStart;
+    bool ok = true;
+
+    while (ok && outputPos < end)
+    {
+        const uint32_t numRead = reader.read(inputs.data(), cycleSize);
+
+        // past the end of the file, silence pushes out the remaining latency
+        for (uint32_t c = 0; c < info.numChannels; ++c)
+            std::memset(inputs[c] + numRead, 0, sizeof(float) * (cycleSize - numRead));
+
+        for (uint32_t i = 0; i < numInstances; ++i)
+            plugins[i]->run(const_cast<const float**>(inputs.data() + i * kNumChannels),
+                            outputs.data() + i * kNumChannels, cycleSize);
+
+        const uint32_t offset = std::min(latencyToSkip, cycleSize);
+        const uint32_t frames = static_cast<uint32_t>(std::min<uint64_t>(cycleSize - offset, end - outputPos));
+        latencyToSkip -= offset;
+
+        // still warming up
+        const uint32_t skip = static_cast<uint32_t>(std::min<uint64_t>(frames, start - std::min(start, outputPos)));
+
+        if (frames == skip)
+        {
+            outputPos += frames;
+            continue;
+        }
+
+        float vad = 0.f;
+       #ifndef SIMPLIFIED_NOOICE
+        if (options.vadTimeline)
+            for (const std::unique_ptr<PluginExporter>& plugin : plugins)
+                vad = std::max(vad, plugin->getParameterValue(kParamCurrentVAD));
+       #endif
+
+        for (uint32_t c = 0; c < info.numChannels; ++c)
+            keptOutputs[c] = outputs[c] + offset + skip;
+
+        ok = callback(keptOutputs.data(), frames - skip, outputPos + skip, vad);
+        outputPos += frames;
+    }
+
+    for (std::unique_ptr<PluginExporter>& plugin : plugins)
+        plugin->deactivate();
+
+    return ok;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Denoised output file, plus its optional VAD timeline.
+ */
+class OutputFile
+{
+public:
+    OutputFile(const Options& o)
+        : options(o) {}
+
+    ~OutputFile()
+    {
+        close();
+    }
+
+    bool open(const std::string& filename, const AudioFileInfo& fileInfo)
+    {
+        info = fileInfo;
+
+        if (! writer.open(filename.c_str(), info))
+            return false;
+
+        if (options.vadTimeline)
+        {
+            const std::string timelineFilename = getTimelineFilename(filename);
+
+            if ((timeline = std::fopen(timelineFilename.c_str(), "w")) == nullptr)
+            {
+                d_stderr2("Failed to create VAD timeline file '%s'", timelineFilename.c_str());
+                return false;
+            }
+
+            std::fprintf(timeline, "time,vad\n");
+        }
+
+        return true;
+    }
+
+    bool close()
+    {
+        bool ok = writer.close();
+
+        if (timeline != nullptr)
+        {
+            if (std::fclose(timeline) != 0)
+                ok = false;
+
+            timeline = nullptr;
+        }
+
+        return ok;
+    }
+
+   /**
+      Write a cycle of output for frame @a pos of the input, along with its VAD.
+    */
+    bool write(const float* const* const outputs, const uint32_t frames, const uint64_t pos, const float vad)
+    {
+        // one row per 10ms step of the file, so rows do not depend on where cycles or segments were split
+        if (timeline != nullptr)
+        {
+            const uint64_t cycleSize = getCycleSize(info);
+            const uint64_t step = (pos + cycleSize - 1) / cycleSize * cycleSize;
+
+            if (step < pos + frames)
+                std::fprintf(timeline, "%.2f,%.1f\n", static_cast<double>(step / cycleSize) / 100.0, vad);
+        }
+
+        // fully muted cycles are left out when trimming silence
+        bool silent = options.trimSilence;
+        for (uint32_t c = 0; silent && c < info.numChannels; ++c)
+            for (uint32_t i = 0; silent && i < frames; ++i)
+                silent = outputs[c][i] == 0.f;
+
+        return silent || writer.write(outputs, frames);
+    }
+
+private:
+    const Options& options;
+    AudioFileInfo info;
+    AudioFileWriter writer;
+    FILE* timeline = nullptr;
+
+    DISTRHO_DECLARE_NON_COPYABLE(OutputFile)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Output of a segment that could not be written right away, kept until the segments before it are done.
+ */
+struct SegmentOutput {
+    std::vector<std::vector<float>> channels;
+    std::vector<uint32_t> cycleFrames;
+    std::vector<float> cycleVads;
+    uint64_t start = 0;
+
+    bool store(const float* const* const outputs, const uint32_t frames, const float vad)
+    {
+        for (size_t c = 0; c < channels.size(); ++c)
+            channels[c].insert(channels[c].end(), outputs[c], outputs[c] + frames);
+
+        cycleFrames.push_back(frames);
+        cycleVads.push_back(vad);
+        return true;
+    }
+
+    bool writeTo(OutputFile& output) const
+    {
+        std::vector<const float*> ptrs(channels.size());
+        uint64_t pos = 0;
+
+        for (size_t i = 0; i < cycleFrames.size(); ++i)
+        {
+            for (size_t c = 0; c < channels.size(); ++c)
+                ptrs[c] = channels[c].data() + pos;
+
+            if (! output.write(ptrs.data(), cycleFrames[i], start + pos, cycleVads[i]))
+                return false;
+
+            pos += cycleFrames[i];
+        }
+
+        return true;
+    }
+};
+
+/**
+   A file being denoised, possibly as several segments on different threads.
+   Segment 0 writes straight to the output, later ones wait for their turn once processed.
+ */
+struct FileJob {
+    std::string inputFilename;
+    std::string outputFilename;
+    AudioFileInfo info;
+    uint64_t segmentFrames = 0;
+    uint32_t warmupFrames = 0;
+    uint32_t numSegments = 1;
+
+    OutputFile output;
+    std::mutex mutex;
+    std::condition_variable segmentWritten;
+    uint32_t nextSegmentToWrite = 0;
+    bool ok = true;
+    uint64_t timeStart = 0;
+
+    FileJob(const Options& options)
+        : output(options) {}
+};
+
+struct SegmentJob {
+    FileJob* file;
+    uint32_t segment;
+};
+
+/**
+   Process a single segment of a file, and write it when all segments before it have been written.
+   Returns true if this was the last segment, meaning the file is done.
+ */
+static bool processSegment(FileJob& file, const uint32_t segment, const Options& options)
+{
+    const uint64_t start = file.segmentFrames * segment;
+    const uint64_t end = segment + 1 == file.numSegments ? file.info.numFrames : start + file.segmentFrames;
+    const uint64_t warmupStart = start - std::min<uint64_t>(start, file.warmupFrames);
+
+    AudioFileReader reader;
+    bool ok = reader.open(file.inputFilename.c_str());
+
+    if (segment == 0)
+    {
+        ok = ok && file.output.open(file.outputFilename, file.info);
+        ok = ok && denoiseRange(reader, options, warmupStart, start, end,
+                                [&file](const float* const* outputs, uint32_t frames, uint64_t pos, float vad)
+                                { return file.output.write(outputs, frames, pos, vad); });
+    }
+    else
+    {
+        SegmentOutput segmentOutput;
+        segmentOutput.channels.resize(file.info.numChannels);
+        segmentOutput.start = start;
+
+        for (std::vector<float>& channel : segmentOutput.channels)
+            channel.reserve(end - start);
+
+        ok = ok && denoiseRange(reader, options, warmupStart, start, end,
+                                [&segmentOutput](const float* const* outputs, uint32_t frames, uint64_t, float vad)
+                                { return segmentOutput.store(outputs, frames, vad); });
+
+        std::unique_lock<std::mutex> lock(file.mutex);
+        file.segmentWritten.wait(lock, [&file, segment]() { return file.nextSegmentToWrite == segment; });
+
+        ok = ok && file.ok && segmentOutput.writeTo(file.output);
+    }
+
+    const std::lock_guard<std::mutex> lock(file.mutex);
+
+    if (! ok)
+        file.ok = false;
+
+    ++file.nextSegmentToWrite;
+    file.segmentWritten.notify_all();
+
+    if (file.nextSegmentToWrite != file.numSegments)
+        return false;
+
+    if (! file.output.close())
+        file.ok = false;
+
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static void printJsonString(const char* const str)
+{
+    std::putchar('"');
+    for (const char* s = str; *s != '\0'; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+            std::printf("\\%c", *s);
+        else if (static_cast<uint8_t>(*s) < 0x20)
+            std::printf("\\u%04x", *s);
+        else
+            std::putchar(*s);
+    }
+    std::putchar('"');
+}
+
+/**
+   Measure how far segmented output is from sequential processing for a range of warm-up lengths.
+   Only the first seconds after each segment start are compared, as that is where the difference is.
+   Results are printed as JSON.
+ */
+static bool reportWarmup(const char* const filename, const Options& options, const bool first)
+{
+    AudioFileReader reader;
+    if (! reader.open(filename))
+        return false;
+
+    const AudioFileInfo info(reader.getInfo());
+    const uint32_t cycleSize = getCycleSize(info);
+    const uint64_t segmentFrames = std::max<uint64_t>(1, static_cast<uint64_t>(options.segmentSeconds * 100)) * cycleSize;
+    const uint64_t compareFrames = std::min<uint64_t>(segmentFrames, kReportCompareSeconds * info.sampleRate);
+    const uint32_t numSeams = static_cast<uint32_t>((info.numFrames - 1) / segmentFrames);
+
+    if (numSeams == 0)
+    {
+        d_stderr2("'%s' is not longer than a segment, nothing to compare", filename);
+        return false;
+    }
+
+    // sequential output right after each segment start
+    std::vector<std::vector<float>> reference(static_cast<size_t>(numSeams) * info.numChannels);
+
+    for (std::vector<float>& channel : reference)
+        channel.resize(compareFrames);
+
+    const bool sequentialOk = denoiseRange(reader, options, 0, 0, info.numFrames,
+        [&](const float* const* outputs, const uint32_t frames, const uint64_t pos, float)
+        {
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                const uint64_t seam = (pos + i) / segmentFrames;
+                const uint64_t offset = (pos + i) % segmentFrames;
+
+                if (seam == 0 || seam > numSeams || offset >= compareFrames)
+                    continue;
+
+                for (uint32_t c = 0; c < info.numChannels; ++c)
+                    reference[(seam - 1) * info.numChannels + c][offset] = outputs[c][i];
+            }
+            return true;
+        });
+
+    DISTRHO_SAFE_ASSERT_RETURN(sequentialOk, false);
+
+    std::printf("%s  {\n", first ? "" : ",\n");
+    std::printf("    \"input\": ");
+    printJsonString(filename);
+    std::printf(",\n");
+    std::printf("    \"segment_seconds\": %.2f,\n", static_cast<double>(segmentFrames) / info.sampleRate);
+    std::printf("    \"seams\": %u,\n", numSeams);
+    std::printf("    \"compare_seconds\": %.2f,\n", static_cast<double>(compareFrames) / info.sampleRate);
+    std::printf("    \"results\": [\n");
+
+    for (size_t w = 0; w < ARRAY_SIZE(kReportWarmups); ++w)
+    {
+        const uint64_t warmupFrames = (kReportWarmups[w] * static_cast<uint64_t>(info.sampleRate) / 1000
+                                       + cycleSize - 1) / cycleSize * cycleSize;
+
+        double maxDiff = 0.0, sumSquares = 0.0;
+        uint64_t numSamples = 0, settledFrames = 0;
+
+        for (uint32_t s = 1; s <= numSeams; ++s)
+        {
+            const uint64_t start = segmentFrames * s;
+
+            const bool ok = denoiseRange(reader, options, start - std::min(start, warmupFrames), start,
+                                         std::min(start + compareFrames, info.numFrames),
+                [&](const float* const* outputs, const uint32_t frames, const uint64_t pos, float)
+                {
+                    double cycleMaxDiff = 0.0;
+
+                    for (uint32_t c = 0; c < info.numChannels; ++c)
+                    {
+                        const float* const ref = reference[(s - 1) * info.numChannels + c].data() + (pos - start);
+
+                        for (uint32_t i = 0; i < frames; ++i)
+                        {
+                            const double diff = std::fabs(static_cast<double>(outputs[c][i]) - ref[i]);
+                            cycleMaxDiff = std::max(cycleMaxDiff, diff);
+                            sumSquares += diff * diff;
+                        }
+                    }
+
+                    // settled once no later cycle goes over the limit
+                    if (cycleMaxDiff > std::pow(10.0, kReportSettledDB / 20.0))
+                        settledFrames = std::max(settledFrames, pos + frames - start);
+
+                    maxDiff = std::max(maxDiff, cycleMaxDiff);
+                    numSamples += frames * info.numChannels;
+                    return true;
+                });
+
+            DISTRHO_SAFE_ASSERT_RETURN(ok, false);
+        }
+
+        const double rmsDiff = numSamples != 0 ? std::sqrt(sumSquares / numSamples) : 0.0;
+
+        std::printf("      {\n");
+        std::printf("        \"warmup_ms\": %u,\n", kReportWarmups[w]);
+        std::printf("        \"max_abs_diff\": %.9f,\n", maxDiff);
+        std::printf("        \"max_diff_db\": %.1f,\n", maxDiff > 0.0 ? 20.0 * std::log10(maxDiff) : -200.0);
+        std::printf("        \"rms_diff_db\": %.1f,\n", rmsDiff > 0.0 ? 20.0 * std::log10(rmsDiff) : -200.0);
+        std::printf("        \"settled_ms\": %.0f\n", settledFrames * 1000.0 / info.sampleRate);
+        std::printf("      }%s\n", w + 1 != ARRAY_SIZE(kReportWarmups) ? "," : "");
+    }
+
+    std::printf("    ]\n");
+    std::printf("  }");
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static void printUsage(const char* const name)
+{
+    std::fprintf(stderr, "Usage: %s [options] <input files...>\n"
+                         "  -o, --output-dir <dir>  write denoised files there with the same names,\n"
+                         "                          otherwise next to the input files with a '-denoised' suffix\n"
+                         "  -j, --jobs <count>      number of files or segments to process at once,\n"
+                         "                          defaults to the number of cores\n"
+                         "  --threshold <percent>   mute output while voice activity is below this value\n"
+                         "  --grace-period <ms>     keep output unmuted this long after voice activity stops\n"
+                         "  --model <file>          RNNoise weights file to use instead of the builtin model\n"
+                         "  --vad-timeline          write voice activity every 10ms to a '.vad.csv' file next to each output\n"
+                         "  --trim-silence          leave out muted parts from the output\n"
+                         "  --segment <seconds>     split files into segments of this length, processed in parallel\n"
+                         "  --warmup <seconds>      audio processed and discarded before each segment, defaults to 1\n"
+                         "  --warmup-report         instead of writing output, compare segmented processing against\n"
+                         "                          sequential for a range of warm-up lengths, printed as JSON\n"
+                         "\n"
+                         "WAV and RF64 files are supported, FLAC too if built with libFLAC.\n", name);
+}
+
+static bool parseOptions(Options& options, const int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if ((std::strcmp(arg, "-o") == 0 || std::strcmp(arg, "--output-dir") == 0) && hasValue)
+            options.outputDir = argv[++i];
+        else if ((std::strcmp(arg, "-j") == 0 || std::strcmp(arg, "--jobs") == 0) && hasValue)
+            options.numJobs = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if (std::strcmp(arg, "--threshold") == 0 && hasValue)
+            options.threshold = std::max(0.f, std::min(100.f, static_cast<float>(std::atof(argv[++i]))));
+        else if (std::strcmp(arg, "--grace-period") == 0 && hasValue)
+            options.gracePeriod = std::max(0.f, std::min(1000.f, static_cast<float>(std::atof(argv[++i]))));
+        else if (std::strcmp(arg, "--model") == 0 && hasValue)
+            options.modelFilename = argv[++i];
+        else if (std::strcmp(arg, "--vad-timeline") == 0)
+            options.vadTimeline = true;
+        else if (std::strcmp(arg, "--trim-silence") == 0)
+            options.trimSilence = true;
+        else if (std::strcmp(arg, "--segment") == 0 && hasValue)
+            options.segmentSeconds = std::max(0.0, std::atof(argv[++i]));
+        else if (std::strcmp(arg, "--warmup") == 0 && hasValue)
+            options.warmupSeconds = std::max(0.0, std::atof(argv[++i]));
+        else if (std::strcmp(arg, "--warmup-report") == 0)
+            options.warmupReport = true;
+        else if (arg[0] == '-')
+            return false;
+        else
+            options.inputFilenames.push_back(arg);
+    }
+
+    if (options.numJobs == 0)
+        options.numJobs = std::max(1u, std::thread::hardware_concurrency());
+
+    // comparing needs segments, default to one minute
+    if (options.warmupReport && options.segmentSeconds <= 0.0)
+        options.segmentSeconds = 60.0;
+
+    return ! options.inputFilenames.empty();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+int main(int argc, char* argv[])
+{
+    USE_NAMESPACE_DISTRHO;
+
+    Options options;
+
+    if (! parseOptions(options, argc, argv))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.warmupReport)
+    {
+        bool ok = true;
+
+        std::printf("[\n");
+        for (size_t i = 0; i < options.inputFilenames.size(); ++i)
+            ok = reportWarmup(options.inputFilenames[i], options, i == 0) && ok;
+        std::printf("\n]\n");
+
+        return ok ? 0 : 1;
+    }
+
+    const uint32_t numFiles = static_cast<uint32_t>(options.inputFilenames.size());
+    std::vector<std::unique_ptr<FileJob>> files;
+    std::vector<SegmentJob> jobs;
+    uint32_t numFailed = 0;
+
+    // find out file lengths first, to know how many segments each one needs
+    for (const char* const inputFilename : options.inputFilenames)
+    {
+        FileJob* const file = new FileJob(options);
+        files.emplace_back(file);
+
+        file->inputFilename = inputFilename;
+        file->outputFilename = getOutputFilename(file->inputFilename, options.outputDir);
+
+        AudioFileReader reader;
+
+        if (file->outputFilename == file->inputFilename)
+        {
+            d_stderr2("Output for '%s' would replace it, skipped", inputFilename);
+        }
+        else if (reader.open(inputFilename))
+        {
+            file->info = reader.getInfo();
+
+            // segments start at cycle boundaries, so denoise blocks line up as in sequential processing
+            if (options.segmentSeconds > 0.0)
+            {
+                const uint32_t cycleSize = getCycleSize(file->info);
+                const uint64_t segmentCycles = std::max<uint64_t>(1, static_cast<uint64_t>(options.segmentSeconds * 100));
+
+                file->segmentFrames = segmentCycles * cycleSize;
+                file->warmupFrames = static_cast<uint32_t>(options.warmupSeconds * 100 + 0.5) * cycleSize;
+                file->numSegments = static_cast<uint32_t>(std::max<uint64_t>(1,
+                    (file->info.numFrames + file->segmentFrames - 1) / file->segmentFrames));
+            }
+
+            for (uint32_t s = 0; s < file->numSegments; ++s)
+                jobs.push_back({ file, s });
+
+            continue;
+        }
+
+        ++numFailed;
+        std::fprintf(stderr, "%s: failed\n", inputFilename);
+    }
+
+    const uint32_t numJobs = static_cast<uint32_t>(jobs.size());
+    const uint32_t numThreads = std::min(options.numJobs, numJobs);
+
+    std::atomic<uint32_t> nextJob { 0 };
+    double totalAudioSeconds = 0.0;
+    uint32_t numDone = numFailed;
+
+    const uint64_t timeStart = getMonotonicTimeNs();
+
+    const auto worker = [&]()
+    {
+        for (uint32_t index; (index = nextJob++) < numJobs;)
+        {
+            FileJob& file(*jobs[index].file);
+
+            if (jobs[index].segment == 0)
+                file.timeStart = getMonotonicTimeNs();
+
+            if (! processSegment(file, jobs[index].segment, options))
+                continue;
+
+            const double audioSeconds = static_cast<double>(file.info.numFrames) / file.info.sampleRate;
+            const double seconds = (getMonotonicTimeNs() - file.timeStart) * 1e-9;
+
+            const std::lock_guard<std::mutex> lock(printMutex);
+            ++numDone;
+
+            if (file.ok)
+            {
+                totalAudioSeconds += audioSeconds;
+                std::fprintf(stderr, "[%u/%u] %s: %.1fs of audio in %.2fs\n",
+                             numDone, numFiles, file.outputFilename.c_str(), audioSeconds, seconds);
+            }
+            else
+            {
+                ++numFailed;
+                std::fprintf(stderr, "[%u/%u] %s: failed\n", numDone, numFiles, file.inputFilename.c_str());
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < numThreads; ++i)
+        threads.emplace_back(worker);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    const double seconds = (getMonotonicTimeNs() - timeStart) * 1e-9;
+
+    std::fprintf(stderr, "Denoised %u of %u files, %.1fs of audio in %.2fs (%.1fx real-time) using %u threads\n",
+                 numFiles - numFailed, numFiles, totalAudioSeconds, seconds,
+                 seconds > 0.0 ? totalAudioSeconds / seconds : 0.0, numThreads);
+
+    return numFailed != 0 ? 1 : 0;
+}